@@ -27,6 +27,7 @@
 #define HAMMERJS_OS_WINDOWS
 #endif
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,11 +36,21 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
 #include <sstream>
+#include <string>
+#include <vector>
+
+#include "hash.h"
 
 #if defined(HAMMERJS_OS_WINDOWS)
+#include <io.h>
 #include <windows.h>
 #if !defined(PATH_MAX)
 #define PATH_MAX MAX_PATH
@@ -47,82 +58,1643 @@
 #define PATH_SEPARATOR "\\"
 #else // HAMMERJS_OS_WINDOWS
 #include <dirent.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #define PATH_SEPARATOR "/"
 #endif
 
-using namespace v8;
+#if !defined(O_BINARY)
+#define O_BINARY 0
+#endif
+
+#if defined(HAMMERJS_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/sendfile.h>
+#define HAMMERJS_HAVE_INOTIFY
+#define HAMMERJS_HAVE_SENDFILE
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAMMERJS_HAVE_COPY_FILE_RANGE
+#endif
+#endif
+
+// fs.copy() and fs.concat() move data in chunks of this size.
+static const size_t copyChunkSize = 1 << 30;
+static const size_t copyBufferSize = 256 * 1024;
+
+using namespace v8;
+
+#if defined(HAMMERJS_HAVE_ZLIB)
+
+// Stream buffer which inflates (or deflates) a gzip file through zlib.
+// Plain files opened with a 'z' mode are read as they are.
+class GzipBuffer : public std::streambuf {
+public:
+    GzipBuffer(gzFile file, bool write)
+        : m_file(file)
+        , m_buffer(gzipBufferSize)
+    {
+        gzbuffer(m_file, gzipBufferSize);
+        char* start = &m_buffer[0];
+        if (write)
+            setp(start, start + m_buffer.size());
+        else
+            setg(start, start, start);
+    }
+
+    ~GzipBuffer()
+    {
+        flushBuffer();
+        gzclose(m_file);
+    }
+
+protected:
+    int_type underflow()
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+        int count = gzread(m_file, &m_buffer[0], m_buffer.size());
+        if (count <= 0)
+            return traits_type::eof();
+        setg(&m_buffer[0], &m_buffer[0], &m_buffer[0] + count);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type c)
+    {
+        if (!pbase() || !flushBuffer())
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync()
+    {
+        if (!pbase())
+            return 0;
+        if (!flushBuffer())
+            return -1;
+        return (gzflush(m_file, Z_SYNC_FLUSH) == Z_OK) ? 0 : -1;
+    }
+
+private:
+    static const unsigned gzipBufferSize = 256 * 1024;
+
+    bool flushBuffer()
+    {
+        int count = pptr() - pbase();
+        if (count && gzwrite(m_file, pbase(), count) != count)
+            return false;
+        pbump(-count);
+        return true;
+    }
+
+    gzFile m_file;
+    std::vector<char> m_buffer;
+};
+
+#endif // HAMMERJS_HAVE_ZLIB
+
+// The native side of a Stream object. Plain files go through a std::filebuf,
+// compressed ones through a GzipBuffer.
+class FileStream : public std::iostream {
+public:
+    FileStream()
+        : std::iostream(0)
+        , m_buffer(0)
+        , m_descriptor(-1)
+    {
+    }
+
+    ~FileStream()
+    {
+        close();
+    }
+
+    bool open(const char* name, std::ios::openmode mode, bool compressed)
+    {
+        if (compressed) {
+#if defined(HAMMERJS_HAVE_ZLIB)
+            bool write = (mode & std::ios::out) != 0;
+            gzFile file = gzopen(name, write ? "wb" : "rb");
+            if (!file)
+                return false;
+            m_buffer = new GzipBuffer(file, write);
+#else
+            return false;
+#endif
+        } else {
+            std::filebuf* buffer = new std::filebuf;
+            if (!buffer->open(name, mode)) {
+                delete buffer;
+                return false;
+            }
+            m_buffer = buffer;
+
+            // A second descriptor for positioned reads and writes, which
+            // leave the position of the sequential functions alone.
+            int flags = O_RDONLY;
+            if (mode & std::ios::out)
+                flags = (mode & std::ios::in) ? O_RDWR : O_WRONLY;
+            m_descriptor = ::open(name, flags | O_BINARY);
+        }
+        rdbuf(m_buffer);
+        return true;
+    }
+
+    void close()
+    {
+        if (!m_buffer)
+            return;
+        rdbuf(0);
+        delete m_buffer;
+        m_buffer = 0;
+        if (m_descriptor >= 0)
+            ::close(m_descriptor);
+        m_descriptor = -1;
+    }
+
+    // -1 for a closed or compressed stream.
+    int descriptor() const { return m_descriptor; }
+
+private:
+    std::streambuf* m_buffer;
+    int m_descriptor;
+};
+
+// Reads up to length bytes at the given offset, without moving the file
+// position. Returns the number of bytes read, or -1 on failure.
+static long long readFileAt(int fd, char* buffer, size_t length, long long offset)
+{
+    size_t total = 0;
+    while (total < length) {
+#if defined(HAMMERJS_OS_WINDOWS)
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>(offset + total);
+        overlapped.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+        DWORD result = 0;
+        if (!::ReadFile(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), buffer + total, static_cast<DWORD>(length - total), &result, &overlapped)) {
+            if (::GetLastError() == ERROR_HANDLE_EOF)
+                break;
+            return -1;
+        }
+#else
+        ssize_t result = ::pread(fd, buffer + total, length - total, offset + total);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+#endif
+        if (result == 0)
+            break;
+        total += result;
+    }
+    return total;
+}
+
+// Writes length bytes at the given offset, without moving the file position.
+static bool writeFileAt(int fd, const char* buffer, size_t length, long long offset)
+{
+    size_t total = 0;
+    while (total < length) {
+#if defined(HAMMERJS_OS_WINDOWS)
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>(offset + total);
+        overlapped.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+        DWORD result = 0;
+        if (!::WriteFile(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), buffer + total, static_cast<DWORD>(length - total), &result, &overlapped))
+            return false;
+#else
+        ssize_t result = ::pwrite(fd, buffer + total, length - total, offset + total);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+#endif
+        total += result;
+    }
+    return true;
+}
+
+static void CleanupStream(Persistent<Value>, void *data)
+{
+    delete reinterpret_cast<FileStream*>(data);
+}
+
+enum FileType {
+    FileTypeNone,
+    FileTypeFile,
+    FileTypeDirectory,
+    FileTypeFifo,
+    FileTypeSocket,
+    FileTypeDevice,
+    FileTypeOther
+};
+
+// Everything a single stat of a path tells us. fs.exists(), fs.isFile(),
+// fs.isDirectory() and fs.stat() are all answered from one of these.
+struct FileStatus {
+    FileType type;
+    unsigned mode;
+    double size;
+    double mtime; // milliseconds since the epoch
+    double inode;
+    double device;
+};
+
+typedef std::map<std::string, FileStatus> StatCache;
+
+// Opt-in, see fs.enableStatCache(). Failed lookups are cached as well.
+static bool statCacheEnabled = false;
+static StatCache statCache;
+
+static void readFileStatus(const char* name, FileStatus* status)
+{
+    memset(status, 0, sizeof(FileStatus));
+    status->type = FileTypeNone;
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!::GetFileAttributesEx(name, GetFileExInfoStandard, &attr))
+        return;
+
+    bool directory = (attr.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    bool readOnly = (attr.dwFileAttributes & FILE_ATTRIBUTE_READONLY) != 0;
+    status->type = directory ? FileTypeDirectory : FileTypeFile;
+    status->mode = directory ? 040755 : (readOnly ? 0100444 : 0100644);
+    status->size = attr.nFileSizeHigh * 4294967296.0 + attr.nFileSizeLow;
+
+    // FILETIME counts 100-nanosecond intervals since January 1, 1601.
+    ULARGE_INTEGER time;
+    time.LowPart = attr.ftLastWriteTime.dwLowDateTime;
+    time.HighPart = attr.ftLastWriteTime.dwHighDateTime;
+    status->mtime = (time.QuadPart - 116444736000000000ULL) / 10000.0;
+#else
+    struct stat statbuf;
+    if (::stat(name, &statbuf))
+        return;
+
+    if (S_ISREG(statbuf.st_mode))
+        status->type = FileTypeFile;
+    else if (S_ISDIR(statbuf.st_mode))
+        status->type = FileTypeDirectory;
+    else if (S_ISFIFO(statbuf.st_mode))
+        status->type = FileTypeFifo;
+    else if (S_ISSOCK(statbuf.st_mode))
+        status->type = FileTypeSocket;
+    else if (S_ISCHR(statbuf.st_mode) || S_ISBLK(statbuf.st_mode))
+        status->type = FileTypeDevice;
+    else
+        status->type = FileTypeOther;
+    status->mode = statbuf.st_mode;
+    status->size = statbuf.st_size;
+    status->mtime = statbuf.st_mtime * 1000.0;
+    status->inode = statbuf.st_ino;
+    status->device = statbuf.st_dev;
+#endif
+}
+
+static void fileStatus(const char* name, FileStatus* status)
+{
+    if (!statCacheEnabled) {
+        readFileStatus(name, status);
+        return;
+    }
+
+    StatCache::iterator it = statCache.find(name);
+    if (it != statCache.end()) {
+        *status = it->second;
+        return;
+    }
+
+    readFileStatus(name, status);
+    statCache[name] = *status;
+}
+
+static void invalidateFileStatus(const char* name)
+{
+    if (statCacheEnabled)
+        statCache.erase(name);
+}
+
+static const char* fileTypeAsText(FileType type)
+{
+    switch (type) {
+    case FileTypeFile: return "file";
+    case FileTypeDirectory: return "directory";
+    case FileTypeFifo: return "fifo";
+    case FileTypeSocket: return "socket";
+    case FileTypeDevice: return "device";
+    default: break;
+    }
+    return "other";
+}
+
+// Appends everything left to read from 'in' to 'out'. Where possible the
+// data is moved by the kernel and never copied into user space.
+static bool copyFileData(int in, int out)
+{
+#if defined(HAMMERJS_HAVE_COPY_FILE_RANGE)
+    // copy_file_range() may even share extents on copy-on-write file
+    // systems. It fails with EXDEV across file systems on older kernels.
+    for (;;) {
+        ssize_t count = ::copy_file_range(in, NULL, out, NULL, copyChunkSize, 0);
+        if (count == 0)
+            return true;
+        if (count > 0)
+            continue;
+        if (errno == EINTR)
+            continue;
+        if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)
+            return false;
+        break;
+    }
+#endif
+
+#if defined(HAMMERJS_HAVE_SENDFILE)
+    for (;;) {
+        ssize_t count = ::sendfile(out, in, NULL, copyChunkSize);
+        if (count == 0)
+            return true;
+        if (count > 0)
+            continue;
+        if (errno == EINTR)
+            continue;
+        if (errno != EINVAL && errno != ENOSYS)
+            return false;
+        break;
+    }
+#endif
+
+    std::vector<char> buffer(copyBufferSize);
+    for (;;) {
+        int count = ::read(in, &buffer[0], buffer.size());
+        if (count == 0)
+            return true;
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (int written = 0; written < count; ) {
+            int result = ::write(out, &buffer[written], count - written);
+            if (result < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            written += result;
+        }
+    }
+}
+
+// The target is not truncated here: the caller first makes sure that it is
+// none of the sources, then calls truncateForCopy().
+static int openForCopy(const char* name, int mode = 0666)
+{
+    return ::open(name, O_WRONLY | O_CREAT | O_BINARY, mode);
+}
+
+static bool truncateForCopy(int fd)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    return ::_chsize(fd, 0) == 0;
+#else
+    return ::ftruncate(fd, 0) == 0;
+#endif
+}
+
+// Returns true if both descriptors refer to the same file, also through a
+// different path or a hard link.
+static bool isSameFile(int a, int b)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    BY_HANDLE_FILE_INFORMATION infoA, infoB;
+    if (!::GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(a)), &infoA))
+        return false;
+    if (!::GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(b)), &infoB))
+        return false;
+    return infoA.dwVolumeSerialNumber == infoB.dwVolumeSerialNumber
+        && infoA.nFileIndexHigh == infoB.nFileIndexHigh
+        && infoA.nFileIndexLow == infoB.nFileIndexLow;
+#else
+    struct stat statA, statB;
+    if (::fstat(a, &statA) != 0 || ::fstat(b, &statB) != 0)
+        return false;
+    return statA.st_dev == statB.st_dev && statA.st_ino == statB.st_ino;
+#endif
+}
+
+static Handle<Value> fs_copy(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 2)
+        return ThrowException(String::New("Exception: function fs.copy() accepts 2 arguments"));
+
+    String::Utf8Value source(args[0]);
+    String::Utf8Value target(args[1]);
+    invalidateFileStatus(*target);
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    if (!::CopyFile(*source, *target, FALSE))
+        return ThrowException(String::New("Exception: fs.copy() can't copy the file"));
+#else
+    int in = ::open(*source, O_RDONLY);
+    if (in < 0)
+        return ThrowException(String::New("Exception: fs.copy() can't open the source file"));
+
+    struct stat statbuf;
+    int mode = (::fstat(in, &statbuf) == 0) ? (statbuf.st_mode & 0777) : 0666;
+    int out = openForCopy(*target, mode);
+    if (out < 0) {
+        ::close(in);
+        return ThrowException(String::New("Exception: fs.copy() can't create the target file"));
+    }
+    if (isSameFile(in, out)) {
+        ::close(in);
+        ::close(out);
+        return ThrowException(String::New("Exception: fs.copy() can't copy a file onto itself"));
+    }
+    if (!truncateForCopy(out)) {
+        ::close(in);
+        ::close(out);
+        return ThrowException(String::New("Exception: fs.copy() can't create the target file"));
+    }
+
+    bool copied = copyFileData(in, out);
+    ::close(in);
+    if (::close(out) != 0)
+        copied = false;
+    if (!copied)
+        return ThrowException(String::New("Exception: fs.copy() can't copy the file"));
+#endif
+
+    return Undefined();
+}
+
+static Handle<Value> fs_concat(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 2 || !args[1]->IsArray())
+        return ThrowException(String::New("Exception: function fs.concat() accepts a file name and an array of file names"));
+
+    String::Utf8Value target(args[0]);
+    Handle<Array> sources = Handle<Array>::Cast(args[1]);
+    invalidateFileStatus(*target);
+
+    int out = openForCopy(*target);
+    if (out < 0)
+        return ThrowException(String::New("Exception: fs.concat() can't create the target file"));
+
+    // All sources are checked before the target loses its content. They
+    // are opened again below, so that only one is open at a time.
+    for (unsigned i = 0; i < sources->Length(); ++i) {
+        String::Utf8Value source(sources->Get(i));
+        int in = ::open(*source, O_RDONLY | O_BINARY);
+        if (in < 0) {
+            ::close(out);
+            return ThrowException(String::New("Exception: fs.concat() can't open the source file"));
+        }
+        bool same = isSameFile(in, out);
+        ::close(in);
+        if (same) {
+            ::close(out);
+            return ThrowException(String::New("Exception: fs.concat() can't use the target file as a source"));
+        }
+    }
+    if (!truncateForCopy(out)) {
+        ::close(out);
+        return ThrowException(String::New("Exception: fs.concat() can't create the target file"));
+    }
+
+    for (unsigned i = 0; i < sources->Length(); ++i) {
+        String::Utf8Value source(sources->Get(i));
+        int in = ::open(*source, O_RDONLY | O_BINARY);
+        if (in < 0) {
+            ::close(out);
+            return ThrowException(String::New("Exception: fs.concat() can't open the source file"));
+        }
+        bool copied = copyFileData(in, out);
+        ::close(in);
+        if (!copied) {
+            ::close(out);
+            return ThrowException(String::New("Exception: fs.concat() can't copy the file"));
+        }
+    }
+
+    if (::close(out) != 0)
+        return ThrowException(String::New("Exception: fs.concat() can't write the target file"));
+
+    return Undefined();
+}
+
+static Handle<Value> fs_exists(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1)
+        return ThrowException(String::New("Exception: function fs.exists() accepts 1 argument"));
+
+    String::Utf8Value fileName(args[0]);
+
+    FileStatus status;
+    fileStatus(*fileName, &status);
+    return Boolean::New(status.type != FileTypeNone);
+}
+
+static Handle<Value> fs_hash(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function fs.hash() accepts 1 or 2 arguments"));
+
+    String::Utf8Value algorithmName(args[1]);
+    const char* algorithm = (args.Length() == 2) ? *algorithmName : "sha256";
+    Hasher* hasher = Hasher::create(algorithm);
+    if (!hasher)
+        return ThrowException(String::New("Exception: fs.hash() does not support the algorithm"));
+    delete hasher;
+
+    if (args[0]->IsArray()) {
+        Handle<Array> names = Handle<Array>::Cast(args[0]);
+        std::vector<std::string> fileNames;
+        for (unsigned i = 0; i < names->Length(); ++i) {
+            String::Utf8Value name(names->Get(i));
+            fileNames.push_back(std::string(*name, name.length()));
+        }
+
+        std::vector<std::string> digests;
+        hashFiles(fileNames, algorithm, &digests);
+
+        Handle<Array> result = Array::New(digests.size());
+        for (size_t i = 0; i < digests.size(); ++i) {
+            if (digests[i].empty())
+                result->Set(i, Null());
+            else
+                result->Set(i, String::New(digests[i].c_str(), digests[i].size()));
+        }
+        return handle_scope.Close(result);
+    }
+
+    String::Utf8Value name(args[0]);
+    std::string digest;
+    if (!hashFile(*name, algorithm, &digest))
+        return ThrowException(String::New("Exception: fs.hash() can't read the file"));
+
+    return handle_scope.Close(String::New(digest.c_str(), digest.size()));
+}
+
+static Handle<Value> fs_isDirectory(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1)
+        return ThrowException(String::New("Exception: fs.isDirectory() accepts 1 argument"));
+
+    String::Utf8Value name(args[0]);
+
+    FileStatus status;
+    fileStatus(*name, &status);
+    if (status.type == FileTypeNone)
+        return ThrowException(String::New("Exception: fs.isDirectory() can't access the directory"));
+
+    return Boolean::New(status.type == FileTypeDirectory);
+}
+
+static Handle<Value> fs_isFile(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1)
+        return ThrowException(String::New("Exception: fs.isFile() accepts 1 argument"));
+
+    String::Utf8Value name(args[0]);
+
+    FileStatus status;
+    fileStatus(*name, &status);
+    if (status.type == FileTypeNone)
+        return ThrowException(String::New("Exception: fs.isFile() can't access the file"));
+
+    return Boolean::New(status.type == FileTypeFile);
+}
+
+// Read-only view of a whole file, memory-mapped where possible.
+class MappedFile {
+public:
+    MappedFile(const char* name)
+        : m_data(0)
+        , m_size(0)
+        , m_mapped(false)
+        , m_valid(false)
+    {
+#if defined(HAMMERJS_OS_WINDOWS)
+        std::ifstream file(name, std::ios::in | std::ios::binary);
+        if (!file)
+            return;
+        m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        m_data = m_buffer.empty() ? "" : &m_buffer[0];
+        m_size = m_buffer.size();
+        m_valid = true;
+#else
+        int fd = ::open(name, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat statbuf;
+        if (::fstat(fd, &statbuf) == 0) {
+            m_size = statbuf.st_size;
+            m_valid = true;
+            if (m_size == 0) {
+                m_data = "";
+            } else {
+                void* data = ::mmap(0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED) {
+                    m_valid = false;
+                } else {
+                    ::madvise(data, m_size, MADV_SEQUENTIAL);
+                    m_data = static_cast<const char*>(data);
+                    m_mapped = true;
+                }
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if !defined(HAMMERJS_OS_WINDOWS)
+        if (m_mapped)
+            ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    bool isValid() const { return m_valid; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    bool m_mapped;
+    bool m_valid;
+    std::vector<char> m_buffer;
+};
+
+// Interned property names. Data files repeat the same few keys over and over,
+// so each distinct key becomes one V8 symbol, reused for every object.
+class JSONKeyTable {
+public:
+    JSONKeyTable()
+        : m_count(0)
+        , m_entries(64)
+    {
+    }
+
+    ~JSONKeyTable()
+    {
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (!m_entries[i].symbol.IsEmpty())
+                m_entries[i].symbol.Dispose();
+        }
+    }
+
+    Handle<String> get(const char* key, size_t length)
+    {
+        unsigned hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+            hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+
+        size_t mask = m_entries.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            Entry& entry = m_entries[i];
+            if (entry.symbol.IsEmpty())
+                break;
+            if (entry.hash == hash && entry.key.size() == length && !memcmp(entry.key.data(), key, length))
+                return entry.symbol;
+        }
+
+        // Keys which look unique (e.g. ids used as keys) are not worth keeping.
+        if (m_count >= maxKeys || length > maxKeyLength)
+            return String::New(key, length);
+
+        if (2 * (m_count + 1) > m_entries.size())
+            grow();
+        Entry& entry = insert(hash);
+        entry.key.assign(key, length);
+        entry.symbol = Persistent<String>::New(String::NewSymbol(key, length));
+        ++m_count;
+        return entry.symbol;
+    }
+
+private:
+    static const size_t maxKeys = 4096;
+    static const size_t maxKeyLength = 256;
+
+    struct Entry {
+        unsigned hash;
+        std::string key;
+        Persistent<String> symbol;
+    };
+
+    Entry& insert(unsigned hash)
+    {
+        size_t mask = m_entries.size() - 1;
+        size_t i = hash & mask;
+        while (!m_entries[i].symbol.IsEmpty())
+            i = (i + 1) & mask;
+        m_entries[i].hash = hash;
+        return m_entries[i];
+    }
+
+    void grow()
+    {
+        std::vector<Entry> entries(m_entries.size() * 2);
+        entries.swap(m_entries);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].symbol.IsEmpty())
+                continue;
+            Entry& entry = insert(entries[i].hash);
+            entry.key.swap(entries[i].key);
+            entry.symbol = entries[i].symbol;
+        }
+    }
+
+    size_t m_count;
+    std::vector<Entry> m_entries;
+};
+
+// Builds V8 values straight from JSON text (RFC 4627), without an
+// intermediate JavaScript string.
+class JSONReader {
+public:
+    JSONReader(JSONKeyTable& keys)
+        : m_keys(keys)
+        , m_start(0)
+        , m_p(0)
+        , m_end(0)
+        , m_depth(0)
+        , m_error(0)
+    {
+    }
+
+    // Parses exactly one value, surrounded by optional whitespace.
+    Handle<Value> parse(const char* data, size_t length)
+    {
+        m_start = m_p = data;
+        m_end = data + length;
+        m_depth = 0;
+        m_error = 0;
+
+        skipWhitespace();
+        Handle<Value> value = parseValue();
+        skipWhitespace();
+        if (!value.IsEmpty() && m_p != m_end)
+            return fail("unexpected data after the value");
+        return value;
+    }
+
+    const char* error() const { return m_error; }
+
+    int errorLine() const
+    {
+        return 1 + std::count(m_start, m_p, '\n');
+    }
+
+private:
+    static const int maxDepth = 1000;
+
+    Handle<Value> fail(const char* error)
+    {
+        if (!m_error)
+            m_error = error;
+        return Handle<Value>();
+    }
+
+    void skipWhitespace()
+    {
+        while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t'))
+            ++m_p;
+    }
+
+    bool consume(const char* literal, size_t length)
+    {
+        if (static_cast<size_t>(m_end - m_p) < length || memcmp(m_p, literal, length))
+            return false;
+        m_p += length;
+        return true;
+    }
+
+    Handle<Value> parseValue()
+    {
+        if (m_p == m_end)
+            return fail("unexpected end of data");
+
+        switch (*m_p) {
+        case '{': return parseObject();
+        case '[': return parseArray();
+        case '"': {
+            const char* characters;
+            size_t length;
+            if (!parseString(&characters, &length))
+                return Handle<Value>();
+            return String::New(characters, length);
+        }
+        case 't':
+            if (consume("true", 4))
+                return True();
+            break;
+        case 'f':
+            if (consume("false", 5))
+                return False();
+            break;
+        case 'n':
+            if (consume("null", 4))
+                return Null();
+            break;
+        default:
+            if (*m_p == '-' || (*m_p >= '0' && *m_p <= '9'))
+                return parseNumber();
+            break;
+        }
+        return fail("unexpected character");
+    }
+
+    Handle<Value> parseObject()
+    {
+        if (++m_depth > maxDepth)
+            return fail("too deeply nested");
+
+        HandleScope handle_scope;
+        Handle<Object> object = Object::New();
+        ++m_p;
+        skipWhitespace();
+        if (m_p < m_end && *m_p == '}') {
+            ++m_p;
+            --m_depth;
+            return handle_scope.Close(object);
+        }
+
+        for (;;) {
+            if (m_p == m_end || *m_p != '"')
+                return fail("expecting a property name");
+            const char* key;
+            size_t keyLength;
+            if (!parseString(&key, &keyLength))
+                return Handle<Value>();
+            Handle<String> name = m_keys.get(key, keyLength);
+
+            skipWhitespace();
+            if (m_p == m_end || *m_p != ':')
+                return fail("expecting ':'");
+            ++m_p;
+            skipWhitespace();
+            Handle<Value> value = parseValue();
+            if (value.IsEmpty())
+                return value;
+            object->Set(name, value);
+
+            skipWhitespace();
+            if (m_p < m_end && *m_p == ',') {
+                ++m_p;
+                skipWhitespace();
+                continue;
+            }
+            if (m_p < m_end && *m_p == '}') {
+                ++m_p;
+                break;
+            }
+            return fail("expecting ',' or '}'");
+        }
+
+        --m_depth;
+        return handle_scope.Close(object);
+    }
+
+    Handle<Value> parseArray()
+    {
+        if (++m_depth > maxDepth)
+            return fail("too deeply nested");
+
+        HandleScope handle_scope;
+        std::vector<Handle<Value> > elements;
+        ++m_p;
+        skipWhitespace();
+        if (m_p < m_end && *m_p == ']') {
+            ++m_p;
+        } else {
+            for (;;) {
+                Handle<Value> value = parseValue();
+                if (value.IsEmpty())
+                    return value;
+                elements.push_back(value);
+
+                skipWhitespace();
+                if (m_p < m_end && *m_p == ',') {
+                    ++m_p;
+                    skipWhitespace();
+                    continue;
+                }
+                if (m_p < m_end && *m_p == ']') {
+                    ++m_p;
+                    break;
+                }
+                return fail("expecting ',' or ']'");
+            }
+        }
+
+        Handle<Array> array = Array::New(elements.size());
+        for (size_t i = 0; i < elements.size(); ++i)
+            array->Set(i, elements[i]);
+        --m_depth;
+        return handle_scope.Close(array);
+    }
+
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    // Appends one UTF-16 unit (surrogates included) encoded on its own,
+    // which V8 decodes back to the very same unit.
+    void appendUTF16(unsigned code)
+    {
+        if (code < 0x80) {
+            m_scratch += static_cast<char>(code);
+        } else if (code < 0x800) {
+            m_scratch += static_cast<char>(0xc0 | (code >> 6));
+            m_scratch += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            m_scratch += static_cast<char>(0xe0 | (code >> 12));
+            m_scratch += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            m_scratch += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    static bool isPlainStringCharacter(char c)
+    {
+        // V8 does not decode 4-byte UTF-8 sequences, these need rewriting.
+        return c != '"' && c != '\\' && static_cast<unsigned char>(c) < 0xf0;
+    }
+
+    // On success, points to the UTF-8 content: either directly into the
+    // source, or into a scratch buffer when there are escape sequences.
+    bool parseString(const char** characters, size_t* length)
+    {
+        const char* begin = ++m_p;
+        while (m_p < m_end && isPlainStringCharacter(*m_p))
+            ++m_p;
+        if (m_p < m_end && *m_p == '"') {
+            *characters = begin;
+            *length = m_p - begin;
+            ++m_p;
+            return true;
+        }
+
+        m_scratch.assign(begin, m_p);
+        while (m_p < m_end && *m_p != '"') {
+            char c = *m_p++;
+            if (static_cast<unsigned char>(c) >= 0xf0 && m_end - m_p >= 3) {
+                unsigned code = ((c & 0x07) << 18) | ((m_p[0] & 0x3f) << 12) | ((m_p[1] & 0x3f) << 6) | (m_p[2] & 0x3f);
+                m_p += 3;
+                code -= 0x10000;
+                appendUTF16(0xd800 | (code >> 10));
+                appendUTF16(0xdc00 | (code & 0x3ff));
+                continue;
+            }
+            if (c != '\\') {
+                m_scratch += c;
+                continue;
+            }
+            if (m_p == m_end)
+                break;
+            switch (*m_p++) {
+            case '"': m_scratch += '"'; break;
+            case '\\': m_scratch += '\\'; break;
+            case '/': m_scratch += '/'; break;
+            case 'b': m_scratch += '\b'; break;
+            case 'f': m_scratch += '\f'; break;
+            case 'n': m_scratch += '\n'; break;
+            case 'r': m_scratch += '\r'; break;
+            case 't': m_scratch += '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                for (int i = 0; i < 4; ++i) {
+                    int digit = (m_p < m_end) ? hexValue(*m_p++) : -1;
+                    if (digit < 0) {
+                        fail("invalid escape sequence");
+                        return false;
+                    }
+                    code = (code << 4) | digit;
+                }
+                appendUTF16(code);
+                break;
+            }
+            default:
+                fail("invalid escape sequence");
+                return false;
+            }
+        }
+        if (m_p == m_end) {
+            fail("unterminated string");
+            return false;
+        }
+        ++m_p;
+        *characters = m_scratch.data();
+        *length = m_scratch.size();
+        return true;
+    }
+
+    Handle<Value> parseNumber()
+    {
+        const char* begin = m_p;
+        bool negative = *m_p == '-';
+        if (negative)
+            ++m_p;
+
+        // Integers up to 15 digits are exact as a double, no strtod needed.
+        double integer = 0;
+        const char* digits = m_p;
+        while (m_p < m_end && *m_p >= '0' && *m_p <= '9')
+            integer = integer * 10 + (*m_p++ - '0');
+        if (m_p == digits || (*digits == '0' && m_p - digits > 1))
+            return fail("invalid number");
+
+        bool simple = (m_p - digits) <= 15;
+        // The fraction and the exponent need at least one digit each.
+        if (m_p < m_end && *m_p == '.') {
+            simple = false;
+            ++m_p;
+            digits = m_p;
+            while (m_p < m_end && *m_p >= '0' && *m_p <= '9')
+                ++m_p;
+            if (m_p == digits)
+                return fail("invalid number");
+        }
+        if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+            simple = false;
+            ++m_p;
+            if (m_p < m_end && (*m_p == '+' || *m_p == '-'))
+                ++m_p;
+            digits = m_p;
+            while (m_p < m_end && *m_p >= '0' && *m_p <= '9')
+                ++m_p;
+            if (m_p == digits)
+                return fail("invalid number");
+        }
+
+        if (simple) {
+            if (negative)
+                integer = -integer;
+            if (integer >= -2147483647.0 && integer <= 2147483647.0 && !(negative && integer == 0))
+                return Integer::New(static_cast<int32_t>(integer));
+            return Number::New(integer);
+        }
+
+        std::string text(begin, m_p);
+        return Number::New(strtod(text.c_str(), 0));
+    }
+
+    JSONKeyTable& m_keys;
+    const char* m_start;
+    const char* m_p;
+    const char* m_end;
+    int m_depth;
+    const char* m_error;
+    std::string m_scratch;
+};
+
+static Handle<Value> throwJSONError(const char* function, const JSONReader& reader, int line)
+{
+    std::ostringstream message;
+    message << "Exception: " << function << " can't parse the file, " << reader.error() << " at line " << line;
+    return ThrowException(String::New(message.str().c_str()));
+}
+
+// RFC 4180 reader behind fs.readCSV(). Records are parsed straight from a
+// large file buffer and only the wanted columns are copied out.
+class CSVReader {
+public:
+    CSVReader(char delimiter)
+        : m_delimiter(delimiter)
+        , m_file(0)
+        , m_buffer(csvBufferSize)
+        , m_position(0)
+        , m_end(0)
+        , m_projected(false)
+        , m_fieldCount(0)
+    {
+    }
+
+    ~CSVReader()
+    {
+        if (m_file)
+            fclose(m_file);
+    }
+
+    bool open(const char* name)
+    {
+        m_file = fopen(name, "rb");
+        return m_file != 0;
+    }
+
+    // Column indices are below this, so that the slot table stays small.
+    static const int maximumColumns = 1 << 20;
+
+    // Restricts the copied fields to the given columns, in the given order.
+    // The columns must be distinct and in the range [0, maximumColumns).
+    void project(const std::vector<int>& columns)
+    {
+        m_projected = true;
+        m_slots.clear();
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i] >= static_cast<int>(m_slots.size()))
+                m_slots.resize(columns[i] + 1, -1);
+            m_slots[columns[i]] = i;
+        }
+        m_fields.resize(columns.size());
+    }
+
+    // Reads the next non-blank record. Returns false at the end of file.
+    bool readRecord()
+    {
+        for (;;) {
+            if (m_position == m_end && !refill())
+                return false;
+            m_fieldCount = 0;
+            for (size_t i = 0; i < m_fields.size(); ++i)
+                m_fields[i].present = false;
+            if (parseRecord())
+                return true;
+        }
+    }
+
+    // Number of fields available through field(), i.e. the projected
+    // columns, or all columns of the current record.
+    size_t fieldCount() const { return m_projected ? m_fields.size() : m_fieldCount; }
+
+    bool isPresent(size_t index) const { return m_fields[index].present; }
+    bool isQuoted(size_t index) const { return m_fields[index].quoted; }
+    const std::string& field(size_t index) const { return m_fields[index].text; }
+
+private:
+    static const size_t csvBufferSize = 256 * 1024;
+
+    struct Field {
+        std::string text;
+        bool quoted;
+        bool present;
+    };
+
+    bool refill()
+    {
+        size_t count = fread(&m_buffer[0], 1, m_buffer.size(), m_file);
+        m_position = &m_buffer[0];
+        m_end = m_position + count;
+        return count > 0;
+    }
+
+    int next()
+    {
+        if (m_position == m_end && !refill())
+            return EOF;
+        return static_cast<unsigned char>(*m_position++);
+    }
+
+    // Appends characters up to (not including) the first 'a' or 'b', and
+    // returns that character, or EOF.
+    int appendUntil(std::string& text, char a, char b)
+    {
+        for (;;) {
+            const char* start = m_position;
+            while (m_position < m_end && *m_position != a && *m_position != b)
+                ++m_position;
+            text.append(start, m_position);
+            if (m_position < m_end)
+                return static_cast<unsigned char>(*m_position++);
+            if (!refill())
+                return EOF;
+        }
+    }
+
+    Field* slot(size_t column)
+    {
+        if (!m_projected) {
+            if (column >= m_fields.size())
+                m_fields.resize(column + 1);
+            m_fieldCount = column + 1;
+            return &m_fields[column];
+        }
+        if (column >= m_slots.size() || m_slots[column] < 0)
+            return 0;
+        return &m_fields[m_slots[column]];
+    }
+
+    // Returns false for a blank line.
+    bool parseRecord()
+    {
+        for (size_t column = 0; ; ++column) {
+            // Unwanted fields still need parsing, but go to a scratch buffer.
+            Field* field = slot(column);
+            std::string& text = field ? field->text : m_scratch;
+            text.clear();
+
+            // Quoted part, where "" stands for a quote. Anything between
+            // the closing quote and the delimiter is kept as it is.
+            bool quoted = m_position < m_end && *m_position == '"';
+            size_t quotedLength = 0;
+            int c;
+            if (quoted) {
+                ++m_position;
+                // At the end of file (an unterminated quote, or a closing
+                // quote as the last character) the field simply ends: refill()
+                // has moved m_position, so there is nothing to step back to.
+                while (appendUntil(text, '"', '"') != EOF) {
+                    int after = next();
+                    if (after == '"') {
+                        text += '"';
+                        continue;
+                    }
+                    if (after != EOF)
+                        --m_position;
+                    break;
+                }
+                quotedLength = text.size();
+            }
+            c = appendUntil(text, m_delimiter, '\n');
+            if (c == '\n' && text.size() > quotedLength && text[text.size() - 1] == '\r')
+                text.erase(text.size() - 1);
+
+            if (field) {
+                field->quoted = quoted;
+                field->present = true;
+            }
+
+            if (c != m_delimiter)
+                return column > 0 || quoted || !text.empty();
+            if (m_position == m_end && !refill()) {
+                // A delimiter right before the end of file: one more empty field.
+                Field* last = slot(column + 1);
+                if (last) {
+                    last->text.clear();
+                    last->quoted = false;
+                    last->present = true;
+                }
+                return true;
+            }
+        }
+    }
+
+    char m_delimiter;
+    FILE* m_file;
+    std::vector<char> m_buffer;
+    const char* m_position;
+    const char* m_end;
+    bool m_projected;
+    std::vector<int> m_slots;
+    std::vector<Field> m_fields;
+    std::string m_scratch;
+    size_t m_fieldCount;
+};
+
+// Returns true if an unquoted field looks like a JSON-style number. Leading
+// zeros (zip codes, ids) are deliberately left as strings.
+static bool isNumericField(const std::string& text)
+{
+    const char* p = text.c_str();
+    if (*p == '-')
+        ++p;
+    if (*p < '0' || *p > '9')
+        return false;
+    if (*p == '0' && p[1] >= '0' && p[1] <= '9')
+        return false;
+    while (*p >= '0' && *p <= '9')
+        ++p;
+    if (*p == '.') {
+        ++p;
+        if (*p < '0' || *p > '9')
+            return false;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+    }
+    if (*p == 'e' || *p == 'E') {
+        ++p;
+        if (*p == '+' || *p == '-')
+            ++p;
+        if (*p < '0' || *p > '9')
+            return false;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+    }
+    return *p == 0;
+}
+
+static Handle<Value> convertCSVField(const CSVReader& reader, size_t index, int numeric)
+{
+    if (!reader.isPresent(index))
+        return Null();
+
+    const std::string& text = reader.field(index);
+    if (numeric > 0) {
+        if (text.empty())
+            return Null();
+        char* end;
+        double number = strtod(text.c_str(), &end);
+        return Number::New(*end ? std::numeric_limits<double>::quiet_NaN() : number);
+    }
+    if (numeric < 0 && !reader.isQuoted(index) && isNumericField(text))
+        return Number::New(strtod(text.c_str(), 0));
+
+    return String::New(text.c_str(), text.size());
+}
+
+static Handle<Value> fs_readCSV(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() < 1 || args.Length() > 3)
+        return ThrowException(String::New("Exception: function fs.readCSV() accepts 1 to 3 arguments"));
+
+    Handle<Object> options = Object::New();
+    Handle<Function> callback;
+    for (int i = 1; i < args.Length(); ++i) {
+        if (args[i]->IsFunction())
+            callback = Handle<Function>::Cast(args[i]);
+        else if (args[i]->IsObject())
+            options = args[i]->ToObject();
+    }
+
+    char delimiter = ',';
+    if (options->Has(String::New("delimiter"))) {
+        String::Utf8Value text(options->Get(String::New("delimiter")));
+        if (text.length() != 1)
+            return ThrowException(String::New("Exception: fs.readCSV() delimiter must be a single character"));
+        delimiter = (*text)[0];
+    }
+    bool header = !options->Has(String::New("header")) || options->Get(String::New("header"))->BooleanValue();
+    int batchSize = 1000;
+    if (options->Has(String::New("batchSize")))
+        batchSize = std::max(1, options->Get(String::New("batchSize"))->Int32Value());
+
+    String::Utf8Value name(args[0]);
+    CSVReader reader(delimiter);
+    if (!reader.open(*name))
+        return ThrowException(String::New("Exception: fs.readCSV() can't read the file"));
+
+    std::vector<std::string> names;
+    if (header && reader.readRecord()) {
+        for (size_t i = 0; i < reader.fieldCount(); ++i)
+            names.push_back(reader.field(i));
+    }
+
+    // Projection: the wanted columns, by name (with a header) or by index.
+    std::vector<int> columns;
+    Handle<Value> wanted = options->Get(String::New("columns"));
+    if (wanted->IsArray()) {
+        Handle<Array> list = Handle<Array>::Cast(wanted);
+        for (unsigned i = 0; i < list->Length(); ++i) {
+            Handle<Value> column = list->Get(i);
+            int index;
+            if (column->IsNumber()) {
+                double value = column->NumberValue();
+                if (!(value >= 0 && value < CSVReader::maximumColumns) || value != static_cast<int>(value))
+                    return ThrowException(String::New("Exception: fs.readCSV() column indices must be integers from 0 to 1048575"));
+                index = static_cast<int>(value);
+            } else {
+                String::Utf8Value text(column);
+                std::vector<std::string>::iterator it = std::find(names.begin(), names.end(), std::string(*text));
+                if (it == names.end())
+                    return ThrowException(String::New("Exception: fs.readCSV() can't find the column"));
+                index = it - names.begin();
+            }
+            if (std::find(columns.begin(), columns.end(), index) != columns.end())
+                return ThrowException(String::New("Exception: fs.readCSV() can't use a column twice"));
+            columns.push_back(index);
+        }
+    } else {
+        for (size_t i = 0; i < names.size(); ++i)
+            columns.push_back(i);
+    }
+    // With a header, the rows only have the keys of the projected columns,
+    // so the projection applies even when it is empty.
+    if (wanted->IsArray() || header)
+        reader.project(columns);
+
+    // Numeric conversion: per projected column, 1 forces it, 0 never,
+    // and -1 converts the unquoted fields which look like numbers.
+    Handle<Value> numericOption = options->Get(String::New("numeric"));
+    int numericDefault = (numericOption->IsUndefined() || numericOption->IsTrue()) ? -1 : 0;
+    std::vector<int> numeric(columns.size(), numericDefault);
+    if (numericOption->IsArray()) {
+        Handle<Array> list = Handle<Array>::Cast(numericOption);
+        for (unsigned i = 0; i < list->Length(); ++i) {
+            Handle<Value> column = list->Get(i);
+            int index = -1;
+            if (column->IsNumber()) {
+                index = column->Int32Value();
+            } else {
+                String::Utf8Value text(column);
+                std::vector<std::string>::iterator it = std::find(names.begin(), names.end(), std::string(*text));
+                if (it != names.end())
+                    index = it - names.begin();
+            }
+            std::vector<int>::iterator it = std::find(columns.begin(), columns.end(), index);
+            if (it != columns.end())
+                numeric[it - columns.begin()] = 1;
+        }
+    }
+
+    // Rows are objects keyed by the header names, or plain arrays.
+    JSONKeyTable keyTable;
+    std::vector<Handle<String> > keys;
+    if (header) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            const std::string& key = (columns[i] < static_cast<int>(names.size())) ? names[columns[i]] : std::string();
+            keys.push_back(keyTable.get(key.c_str(), key.size()));
+        }
+    }
+
+    Handle<Array> all = Array::New();
+    int count = 0;
+    bool done = false;
+    while (!done) {
+        HandleScope batch_scope;
+        Handle<Array> batch = callback.IsEmpty() ? all : Array::New();
+        int batchCount = 0;
+        while (batchCount < batchSize || callback.IsEmpty()) {
+            if (!reader.readRecord()) {
+                done = true;
+                break;
+            }
+            HandleScope row_scope;
+            size_t fieldCount = reader.fieldCount();
+            Handle<Object> row;
+            if (header) {
+                row = Object::New();
+                for (size_t i = 0; i < fieldCount; ++i) {
+                    if (reader.isPresent(i))
+                        row->Set(keys[i], convertCSVField(reader, i, numeric[i]));
+                }
+            } else {
+                Handle<Array> fields = Array::New(fieldCount);
+                for (size_t i = 0; i < fieldCount; ++i)
+                    fields->Set(i, convertCSVField(reader, i, (i < numeric.size()) ? numeric[i] : numericDefault));
+                row = fields;
+            }
+            batch->Set(callback.IsEmpty() ? count : batchCount, row);
+            ++batchCount;
+            ++count;
+        }
+
+        if (callback.IsEmpty() || !batchCount)
+            continue;
+
+        TryCatch tryCatch;
+        Handle<Value> argv[1] = { batch };
+        Handle<Value> result = callback->Call(Context::GetCurrent()->Global(), 1, argv);
+        if (tryCatch.HasCaught())
+            return tryCatch.ReThrow();
+        if (result->IsFalse())
+            break;
+    }
+
+    if (callback.IsEmpty())
+        return handle_scope.Close(all);
+    return Integer::New(count);
+}
+
+static Handle<Value> fs_readJSON(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1)
+        return ThrowException(String::New("Exception: function fs.readJSON() accepts 1 argument"));
+
+    String::Utf8Value name(args[0]);
+    MappedFile file(*name);
+    if (!file.isValid())
+        return ThrowException(String::New("Exception: fs.readJSON() can't read the file"));
 
-static void CleanupStream(Persistent<Value>, void *data)
-{
-    delete reinterpret_cast<std::fstream*>(data);
+    JSONKeyTable keys;
+    JSONReader reader(keys);
+    Handle<Value> result = reader.parse(file.data(), file.size());
+    if (result.IsEmpty())
+        return throwJSONError("fs.readJSON()", reader, reader.errorLine());
+
+    return handle_scope.Close(result);
 }
 
-static Handle<Value> fs_exists(const Arguments& args)
+static Handle<Value> fs_readJSONLines(const Arguments& args)
 {
     HandleScope handle_scope;
 
-    if (args.Length() != 1)
-        return ThrowException(String::New("Exception: function fs.exists() accepts 1 argument"));
+    if (args.Length() != 2 || !args[1]->IsFunction())
+        return ThrowException(String::New("Exception: function fs.readJSONLines() accepts a file name and a callback function"));
 
-    String::Utf8Value fileName(args[0]);
+    String::Utf8Value name(args[0]);
+    std::ifstream file(*name, std::ios::in | std::ios::binary);
+    if (!file)
+        return ThrowException(String::New("Exception: fs.readJSONLines() can't read the file"));
+
+    Handle<Function> callback = Handle<Function>::Cast(args[1]);
+    JSONKeyTable keys;
+    JSONReader reader(keys);
+    std::string line;
+    int lineNumber = 0;
+    int index = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        HandleScope line_scope;
+        Handle<Value> value = reader.parse(line.data(), line.size());
+        if (value.IsEmpty())
+            return throwJSONError("fs.readJSONLines()", reader, lineNumber);
+
+        TryCatch tryCatch;
+        Handle<Value> argv[2] = { value, Integer::New(index++) };
+        Handle<Value> result = callback->Call(Context::GetCurrent()->Global(), 2, argv);
+        if (tryCatch.HasCaught())
+            return tryCatch.ReThrow();
+        if (result->IsFalse())
+            break;
+    }
 
-#if defined(HAMMERJS_OS_WINDOWS)
-    WIN32_FILE_ATTRIBUTE_DATA attr;
-    bool canStat = ::GetFileAttributesEx(*fileName, GetFileExInfoStandard, &attr) != 0;
-#else
-    struct stat statbuf;
-    bool canStat = ::stat(*fileName, &statbuf) == 0;
-#endif
-    return Boolean::New(canStat);
+    return Integer::New(index);
 }
 
-static Handle<Value> fs_isDirectory(const Arguments& args)
+static Handle<Value> fs_stat(const Arguments& args)
 {
     HandleScope handle_scope;
 
     if (args.Length() != 1)
-        return ThrowException(String::New("Exception: fs.isDirectory() accepts 1 argument"));
+        return ThrowException(String::New("Exception: function fs.stat() accepts 1 argument"));
 
     String::Utf8Value name(args[0]);
 
-#if defined(HAMMERJS_OS_WINDOWS)
-    WIN32_FILE_ATTRIBUTE_DATA attr;
-    if (!::GetFileAttributesEx(*name, GetFileExInfoStandard, &attr))
-        return ThrowException(String::New("Exception: fs.isDirectory() can't access the directory"));
+    FileStatus status;
+    fileStatus(*name, &status);
+    if (status.type == FileTypeNone)
+        return ThrowException(String::New("Exception: fs.stat() can't access the file"));
 
-    return Boolean::New((attr.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
-#else
-    struct stat statbuf;
-    if (::stat(*name, &statbuf))
-        return ThrowException(String::New("Exception: fs.isDirectory() can't access the directory"));
+    Handle<Object> result = Object::New();
+    result->Set(String::New("type"), String::New(fileTypeAsText(status.type)));
+    result->Set(String::New("size"), Number::New(status.size));
+    result->Set(String::New("mode"), Integer::NewFromUnsigned(status.mode));
+    result->Set(String::New("mtime"), Date::New(status.mtime));
+    result->Set(String::New("inode"), Number::New(status.inode));
+    result->Set(String::New("device"), Number::New(status.device));
 
-    return Boolean::New(S_ISDIR(statbuf.st_mode));
-#endif
+    return handle_scope.Close(result);
 }
 
-static Handle<Value> fs_isFile(const Arguments& args)
+static Handle<Value> fs_enableStatCache(const Arguments& args)
 {
-    HandleScope handle_scope;
+    if (args.Length() > 1)
+        return ThrowException(String::New("Exception: function fs.enableStatCache() accepts 0 or 1 argument"));
 
-    if (args.Length() != 1)
-        return ThrowException(String::New("Exception: fs.isFile() accepts 1 argument"));
+    statCacheEnabled = (args.Length() == 0) || args[0]->BooleanValue();
+    if (!statCacheEnabled)
+        statCache.clear();
 
-    String::Utf8Value name(args[0]);
+    return Undefined();
+}
 
-#if defined(HAMMERJS_OS_WINDOWS)
-    WIN32_FILE_ATTRIBUTE_DATA attr;
-    if (!::GetFileAttributesEx(*name, GetFileExInfoStandard, &attr))
-        return ThrowException(String::New("Exception: fs.isFile() can't access the file"));
+static Handle<Value> fs_invalidateStatCache(const Arguments& args)
+{
+    HandleScope handle_scope;
 
-    return Boolean::New((attr.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY)) == 0);
-#else
-    struct stat statbuf;
-    if (::stat(*name, &statbuf))
-        return ThrowException(String::New("Exception: fs.isFile() can't access the file"));
+    if (args.Length() > 1)
+        return ThrowException(String::New("Exception: function fs.invalidateStatCache() accepts 0 or 1 argument"));
 
-    return Boolean::New(S_ISREG(statbuf.st_mode));
-#endif
+    if (args.Length() == 1) {
+        String::Utf8Value name(args[0]);
+        statCache.erase(*name);
+    } else {
+        statCache.clear();
+    }
+
+    return Undefined();
 }
 
 static Handle<Value> fs_makeDirectory(const Arguments& args)
@@ -141,6 +1713,7 @@ static Handle<Value> fs_makeDirectory(const Arguments& args)
     if (::mkdir(*directoryName, 0777) != 0)
         return ThrowException(String::New("Exception: fs.makeDirectory() can't create the directory"));
 #endif
+    invalidateFileStatus(*directoryName);
 
     return Undefined();
 }
@@ -195,6 +1768,401 @@ static Handle<Value> fs_list(const Arguments& args)
 #endif
 }
 
+struct DirectoryEntry {
+    std::string name;
+    bool isDirectory;
+    bool isSymbolicLink;
+
+    bool operator<(const DirectoryEntry& other) const { return name < other.name; }
+};
+
+// Lists a directory (without '.' and '..'), sorted by name. Where the
+// platform reports the entry type, no extra stat is needed per entry.
+static bool readDirectory(const std::string& path, std::vector<DirectoryEntry>& entries)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    std::string search = path + "\\*";
+    WIN32_FIND_DATA entry;
+    HANDLE dir = FindFirstFile(search.c_str(), &entry);
+    if (dir == INVALID_HANDLE_VALUE)
+        return false;
+
+    do {
+        if (strcmp(entry.cFileName, ".") && strcmp(entry.cFileName, "..")) {
+            DirectoryEntry e;
+            e.name = entry.cFileName;
+            e.isDirectory = (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            e.isSymbolicLink = (entry.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+            entries.push_back(e);
+        }
+    } while (FindNextFile(dir, &entry) != 0);
+    FindClose(dir);
+#else
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+        return false;
+
+    struct dirent *entry;
+    while ((entry = ::readdir(dir))) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+        DirectoryEntry e;
+        e.name = entry->d_name;
+        e.isSymbolicLink = false;
+#if defined(DT_DIR)
+        e.isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+#endif
+            FileStatus status;
+            fileStatus((path + PATH_SEPARATOR + e.name).c_str(), &status);
+            e.isDirectory = status.type == FileTypeDirectory;
+#if defined(DT_DIR)
+            e.isSymbolicLink = entry->d_type == DT_LNK;
+        }
+#endif
+        entries.push_back(e);
+    }
+    ::closedir(dir);
+#endif
+
+    std::sort(entries.begin(), entries.end());
+    return true;
+}
+
+// One path component of a glob pattern, e.g. "*.js", "[a-z]?" or "**",
+// compiled into a token list once and then matched against entry names.
+class GlobSegment {
+public:
+    GlobSegment(const std::string& text)
+        : m_globstar(text == "**")
+        , m_literal(true)
+        , m_text(text)
+    {
+        if (!m_globstar)
+            compile(text);
+    }
+
+    bool isGlobstar() const { return m_globstar; }
+
+    bool match(const std::string& name) const
+    {
+        // Wildcards never match a leading dot, as in the shell.
+        bool hidden = !name.empty() && name[0] == '.';
+        if (m_globstar)
+            return !hidden;
+        if (m_literal)
+            return name == m_text;
+        if (hidden && (m_tokens.empty() || m_tokens[0].type != CharToken || m_tokens[0].ch != '.'))
+            return false;
+
+        // Only '*' has a variable length, so remembering the last star is
+        // enough to backtrack; this runs in O(name * pattern) worst case.
+        size_t t = 0, n = 0;
+        size_t star = std::string::npos, starName = 0;
+        while (n < name.size()) {
+            if (t < m_tokens.size() && m_tokens[t].type == StarToken) {
+                star = t++;
+                starName = n;
+            } else if (t < m_tokens.size() && matchToken(m_tokens[t], static_cast<unsigned char>(name[n]))) {
+                ++t;
+                ++n;
+            } else if (star != std::string::npos) {
+                t = star + 1;
+                n = ++starName;
+            } else {
+                return false;
+            }
+        }
+        while (t < m_tokens.size() && m_tokens[t].type == StarToken)
+            ++t;
+        return t == m_tokens.size();
+    }
+
+private:
+    enum TokenType { CharToken, AnyCharToken, StarToken, ClassToken };
+
+    struct Token {
+        TokenType type;
+        unsigned char ch;
+        size_t charClass;
+    };
+
+    struct CharClass {
+        bool negated;
+        unsigned char bits[32];
+
+        bool contains(unsigned char c) const { return (bits[c >> 3] & (1 << (c & 7))) != 0; }
+        void add(unsigned char c) { bits[c >> 3] |= 1 << (c & 7); }
+    };
+
+    bool matchToken(const Token& token, unsigned char c) const
+    {
+        switch (token.type) {
+        case CharToken: return token.ch == c;
+        case AnyCharToken: return true;
+        case ClassToken: return m_classes[token.charClass].contains(c) != m_classes[token.charClass].negated;
+        default: break;
+        }
+        return false;
+    }
+
+    void append(TokenType type, unsigned char ch = 0, size_t charClass = 0)
+    {
+        Token token;
+        token.type = type;
+        token.ch = ch;
+        token.charClass = charClass;
+        m_tokens.push_back(token);
+        if (type != CharToken)
+            m_literal = false;
+    }
+
+    // Parses "[...]" starting at text[i] == '['. Returns the index of the
+    // closing bracket, or 0 when the class is not terminated.
+    size_t compileClass(const std::string& text, size_t i)
+    {
+        CharClass charClass;
+        memset(&charClass, 0, sizeof(CharClass));
+        size_t j = i + 1;
+        if (j < text.size() && (text[j] == '!' || text[j] == '^')) {
+            charClass.negated = true;
+            ++j;
+        }
+        size_t first = j;
+        for (; j < text.size(); ++j) {
+            if (text[j] == ']' && j > first)
+                break;
+            unsigned char low = text[j];
+            if (low == '\\' && j + 1 < text.size())
+                low = text[++j];
+            unsigned char high = low;
+            if (j + 2 < text.size() && text[j + 1] == '-' && text[j + 2] != ']') {
+                high = text[j + 2];
+                j += 2;
+            }
+            for (unsigned c = low; c <= high; ++c)
+                charClass.add(c);
+        }
+        if (j >= text.size())
+            return 0;
+
+        m_classes.push_back(charClass);
+        append(ClassToken, 0, m_classes.size() - 1);
+        return j;
+    }
+
+    void compile(const std::string& text)
+    {
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (c == '\\' && i + 1 < text.size()) {
+                append(CharToken, text[++i]);
+            } else if (c == '*') {
+                if (m_tokens.empty() || m_tokens.back().type != StarToken)
+                    append(StarToken);
+            } else if (c == '?') {
+                append(AnyCharToken);
+            } else if (c == '[') {
+                size_t end = compileClass(text, i);
+                if (end)
+                    i = end;
+                else
+                    append(CharToken, c);
+            } else {
+                append(CharToken, c);
+            }
+        }
+        if (m_literal) {
+            // Drop the escapes, the name is compared as a plain string.
+            m_text.clear();
+            for (size_t i = 0; i < m_tokens.size(); ++i)
+                m_text += m_tokens[i].ch;
+        }
+    }
+
+    bool m_globstar;
+    bool m_literal;
+    std::string m_text;
+    std::vector<Token> m_tokens;
+    std::vector<CharClass> m_classes;
+};
+
+struct GlobPattern {
+    std::vector<GlobSegment> segments;
+    bool ignore;
+};
+
+// A position inside a pattern: segments before 'segment' have matched.
+struct GlobState {
+    size_t pattern;
+    size_t segment;
+};
+
+typedef std::vector<GlobState> GlobStates;
+
+static void compileGlobPattern(const std::string& text, bool ignore, std::vector<GlobPattern>& patterns)
+{
+    std::string pattern = text;
+    if (!pattern.empty() && pattern[0] == '!') {
+        ignore = !ignore;
+        pattern.erase(0, 1);
+    }
+    while (pattern.compare(0, 2, "./") == 0)
+        pattern.erase(0, 2);
+
+    GlobPattern compiled;
+    compiled.ignore = ignore;
+    size_t start = 0;
+    while (start <= pattern.size()) {
+        size_t end = pattern.find('/', start);
+        if (end == std::string::npos)
+            end = pattern.size();
+        std::string segment = pattern.substr(start, end - start);
+        bool repeatedGlobstar = segment == "**" && !compiled.segments.empty() && compiled.segments.back().isGlobstar();
+        if (!segment.empty() && !repeatedGlobstar)
+            compiled.segments.push_back(GlobSegment(segment));
+        start = end + 1;
+    }
+
+    if (!compiled.segments.empty())
+        patterns.push_back(compiled);
+}
+
+static void compileGlobPatterns(Handle<Value> value, bool ignore, std::vector<GlobPattern>& patterns)
+{
+    if (value->IsArray()) {
+        Handle<Array> array = Handle<Array>::Cast(value);
+        for (unsigned i = 0; i < array->Length(); ++i) {
+            String::Utf8Value pattern(array->Get(i));
+            compileGlobPattern(*pattern, ignore, patterns);
+        }
+    } else if (!value->IsUndefined() && !value->IsNull()) {
+        String::Utf8Value pattern(value);
+        compileGlobPattern(*pattern, ignore, patterns);
+    }
+}
+
+// Adds a state and, since "**" may match zero components, every state
+// reachable by skipping globstars.
+static void addGlobState(const std::vector<GlobPattern>& patterns, GlobStates& states, size_t pattern, size_t segment)
+{
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].pattern == pattern && states[i].segment == segment)
+            return;
+    }
+
+    GlobState state;
+    state.pattern = pattern;
+    state.segment = segment;
+    states.push_back(state);
+
+    const std::vector<GlobSegment>& segments = patterns[pattern].segments;
+    if (segment < segments.size() && segments[segment].isGlobstar())
+        addGlobState(patterns, states, pattern, segment + 1);
+}
+
+static void globDirectory(const std::vector<GlobPattern>& patterns, const GlobStates& states,
+                          const std::string& path, const std::string& prefix, std::vector<std::string>& results)
+{
+    std::vector<DirectoryEntry> entries;
+    if (!readDirectory(path, entries))
+        return;
+
+    for (size_t e = 0; e < entries.size(); ++e) {
+        const DirectoryEntry& entry = entries[e];
+
+        GlobStates next;
+        for (size_t i = 0; i < states.size(); ++i) {
+            const GlobSegment& segment = patterns[states[i].pattern].segments[states[i].segment];
+            if (!segment.match(entry.name))
+                continue;
+            addGlobState(patterns, next, states[i].pattern, states[i].segment + (segment.isGlobstar() ? 0 : 1));
+        }
+        if (next.empty())
+            continue;
+
+        bool matched = false;
+        bool ignored = false;
+        for (size_t i = 0; i < next.size(); ++i) {
+            if (next[i].segment == patterns[next[i].pattern].segments.size()) {
+                if (patterns[next[i].pattern].ignore)
+                    ignored = true;
+                else
+                    matched = true;
+            }
+        }
+
+        // An ignored directory is pruned together with everything below it.
+        if (ignored)
+            continue;
+
+        std::string name = prefix + entry.name;
+        if (matched)
+            results.push_back(name);
+
+        if (!entry.isDirectory)
+            continue;
+
+        // Descend only if some include pattern still needs more components.
+        // Symbolic links are not followed by "**", to avoid cycles.
+        GlobStates children;
+        bool wanted = false;
+        for (size_t i = 0; i < next.size(); ++i) {
+            const GlobPattern& pattern = patterns[next[i].pattern];
+            if (next[i].segment == pattern.segments.size())
+                continue;
+            if (entry.isSymbolicLink && pattern.segments[next[i].segment].isGlobstar())
+                continue;
+            children.push_back(next[i]);
+            if (!pattern.ignore)
+                wanted = true;
+        }
+        if (wanted)
+            globDirectory(patterns, children, path + PATH_SEPARATOR + entry.name, name + "/", results);
+    }
+}
+
+static Handle<Value> fs_glob(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function fs.glob() accepts 1 or 2 arguments"));
+
+    std::vector<GlobPattern> patterns;
+    std::string cwd = ".";
+    compileGlobPatterns(args[0], false, patterns);
+    if (args.Length() == 2 && args[1]->IsObject()) {
+        Handle<Object> options = args[1]->ToObject();
+        if (options->Has(String::New("cwd"))) {
+            String::Utf8Value directory(options->Get(String::New("cwd")));
+            cwd = *directory;
+        }
+        if (options->Has(String::New("ignore")))
+            compileGlobPatterns(options->Get(String::New("ignore")), true, patterns);
+    }
+
+    GlobStates states;
+    for (size_t i = 0; i < patterns.size(); ++i)
+        addGlobState(patterns, states, i, 0);
+
+    // Trailing globstars can make a pattern complete before any component.
+    GlobStates initial;
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].segment < patterns[states[i].pattern].segments.size())
+            initial.push_back(states[i]);
+    }
+
+    std::vector<std::string> results;
+    globDirectory(patterns, initial, cwd, "", results);
+
+    Handle<Array> entries = Array::New(results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+        entries->Set(i, String::New(results[i].c_str(), results[i].size()));
+
+    return handle_scope.Close(entries);
+}
+
 static Handle<Value> fs_open(const Arguments& args)
 {
     HandleScope handle_scope;
@@ -215,6 +2183,196 @@ static Handle<Value> fs_open(const Arguments& args)
     return result;
 }
 
+#if defined(HAMMERJS_HAVE_INOTIFY)
+
+// Blocking inotify watcher behind fs.watch(). Events are read from the
+// kernel queue in large chunks and reduced to a set of changed paths.
+class FileWatcher {
+public:
+    FileWatcher(bool recursive)
+        : m_fd(inotify_init())
+        , m_recursive(recursive)
+        , m_overflow(false)
+    {
+    }
+
+    ~FileWatcher()
+    {
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    bool isValid() const { return m_fd >= 0; }
+
+    bool add(const std::string& path)
+    {
+        if (!watchPath(path))
+            return false;
+        m_roots.insert(path);
+        return true;
+    }
+
+    // Waits for events, at most timeout milliseconds (forever if negative).
+    bool wait(int timeout)
+    {
+        struct pollfd fd;
+        fd.fd = m_fd;
+        fd.events = POLLIN;
+        fd.revents = 0;
+        int result;
+        do {
+            result = ::poll(&fd, 1, timeout);
+        } while (result < 0 && errno == EINTR);
+        return result > 0;
+    }
+
+    void read(std::set<std::string>& changes)
+    {
+        char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        for (char* ptr = buffer; length > 0 && ptr < buffer + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                m_overflow = true;
+                continue;
+            }
+
+            std::map<int, std::string>::iterator it = m_paths.find(event->wd);
+            if (it == m_paths.end())
+                continue;
+            if (event->mask & IN_IGNORED) {
+                m_paths.erase(it);
+                continue;
+            }
+
+            std::string path = it->second;
+            if (event->len && event->name[0])
+                path = path + PATH_SEPARATOR + event->name;
+            changes.insert(path);
+            invalidateFileStatus(path.c_str());
+
+            if (m_recursive && (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                watchPath(path);
+        }
+
+        // The kernel dropped events, so anything below the roots may have changed.
+        if (m_overflow) {
+            changes.insert(m_roots.begin(), m_roots.end());
+            if (statCacheEnabled)
+                statCache.clear();
+            m_overflow = false;
+        }
+    }
+
+private:
+    static const uint32_t mask = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF
+        | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO;
+
+    bool watchPath(const std::string& path)
+    {
+        int wd = inotify_add_watch(m_fd, path.c_str(), mask);
+        if (wd < 0)
+            return false;
+        m_paths[wd] = path;
+
+        if (m_recursive) {
+            std::vector<DirectoryEntry> entries;
+            if (readDirectory(path, entries)) {
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    if (entries[i].isDirectory && !entries[i].isSymbolicLink)
+                        watchPath(path + PATH_SEPARATOR + entries[i].name);
+                }
+            }
+        }
+        return true;
+    }
+
+    int m_fd;
+    bool m_recursive;
+    bool m_overflow;
+    std::map<int, std::string> m_paths;
+    std::set<std::string> m_roots;
+};
+
+#endif // HAMMERJS_HAVE_INOTIFY
+
+static Handle<Value> fs_watch(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 2 && args.Length() != 3)
+        return ThrowException(String::New("Exception: function fs.watch() accepts 2 or 3 arguments"));
+
+    if (!args[1]->IsFunction())
+        return ThrowException(String::New("Exception: fs.watch() needs a callback function"));
+
+#if defined(HAMMERJS_HAVE_INOTIFY)
+    Handle<Function> callback = Handle<Function>::Cast(args[1]);
+
+    bool recursive = false;
+    int delay = 50;
+    int timeout = -1;
+    if (args.Length() == 3 && args[2]->IsObject()) {
+        Handle<Object> options = args[2]->ToObject();
+        if (options->Has(String::New("recursive")))
+            recursive = options->Get(String::New("recursive"))->BooleanValue();
+        if (options->Has(String::New("delay")))
+            delay = options->Get(String::New("delay"))->Int32Value();
+        if (options->Has(String::New("timeout")))
+            timeout = options->Get(String::New("timeout"))->Int32Value();
+    }
+
+    FileWatcher watcher(recursive);
+    if (!watcher.isValid())
+        return ThrowException(String::New("Exception: fs.watch() can't create the watcher"));
+
+    if (args[0]->IsArray()) {
+        Handle<Array> paths = Handle<Array>::Cast(args[0]);
+        for (unsigned i = 0; i < paths->Length(); ++i) {
+            String::Utf8Value path(paths->Get(i));
+            if (!watcher.add(*path))
+                return ThrowException(String::New("Exception: fs.watch() can't watch the path"));
+        }
+    } else {
+        String::Utf8Value path(args[0]);
+        if (!watcher.add(*path))
+            return ThrowException(String::New("Exception: fs.watch() can't watch the path"));
+    }
+
+    while (watcher.wait(timeout)) {
+        // Coalesce a burst of events (e.g. an editor save or a checkout)
+        // into one batch: keep reading until the queue stays quiet.
+        std::set<std::string> changes;
+        do {
+            watcher.read(changes);
+        } while (watcher.wait(delay));
+
+        if (changes.empty())
+            continue;
+
+        HandleScope batch_scope;
+        Handle<Array> paths = Array::New(changes.size());
+        int index = 0;
+        for (std::set<std::string>::const_iterator it = changes.begin(); it != changes.end(); ++it, ++index)
+            paths->Set(index, String::New(it->c_str(), it->size()));
+
+        TryCatch tryCatch;
+        Handle<Value> argv[1] = { paths };
+        Handle<Value> result = callback->Call(Context::GetCurrent()->Global(), 1, argv);
+        if (tryCatch.HasCaught())
+            return tryCatch.ReThrow();
+        if (result->IsFalse())
+            break;
+    }
+
+    return Undefined();
+#else
+    return ThrowException(String::New("Exception: fs.watch() is not supported on this platform"));
+#endif
+}
+
 static Handle<Value> fs_workingDirectory(const Arguments& args)
 {
     if (args.Length() != 0)
@@ -245,26 +2403,35 @@ static Handle<Value> stream_constructor(const Arguments& args)
     String::Utf8Value name(args[0]);
     String::Utf8Value modes(args[1]);
 
-    std::fstream::openmode mode = std::fstream::in;
+    std::ios::openmode mode = std::ios::in;
+    bool compressed = false;
     if (args.Length() == 2) {
-        String::Utf8Value m(args[0]);
         const char* options = *modes;
         bool read = strchr(options, 'r');
         bool write = strchr(options, 'w');
+        compressed = strchr(options, 'z');
         if (!read && !write)
             return ThrowException(String::New("Exception: Invalid open mode for Stream"));
+        if (compressed && read && write)
+            return ThrowException(String::New("Exception: A compressed Stream can't be opened for both reading and writing"));
         if (!read)
-            mode = std::fstream::out;
+            mode = std::ios::out;
         if (write)
-            mode |= std::fstream::out;
+            mode |= std::ios::out;
     }
 
-    std::fstream *data = new std::fstream;
-    data->open(*name, mode);
-    if (data->fail() || data->bad()) {
+#if !defined(HAMMERJS_HAVE_ZLIB)
+    if (compressed)
+        return ThrowException(String::New("Exception: Compressed Stream is not supported"));
+#endif
+
+    FileStream *data = new FileStream;
+    if (!data->open(*name, mode, compressed)) {
         delete data;
         return ThrowException(String::New("Exception: Can't open the file"));
     }
+    if (mode & std::ios::out)
+        invalidateFileStatus(*name);
 
     args.This()->SetPointerInInternalField(0, data);
 
@@ -282,9 +2449,12 @@ static Handle<Value> stream_close(const Arguments& args)
         return ThrowException(String::New("Exception: Stream.close() accepts no argument"));
 
     void *data = args.This()->GetPointerFromInternalField(0);
-    std::fstream *fs = reinterpret_cast<std::fstream*>(data);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
     fs->close();
 
+    String::Utf8Value name(args.This()->Get(String::New("name")));
+    invalidateFileStatus(*name);
+
     return Undefined();
 }
 
@@ -294,7 +2464,7 @@ static Handle<Value> stream_flush(const Arguments& args)
         return ThrowException(String::New("Exception: Stream.flush() accepts no argument"));
 
     void *data = args.This()->GetPointerFromInternalField(0);
-    std::fstream *fs = reinterpret_cast<std::fstream*>(data);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
     fs->flush();
 
     return args.This();
@@ -306,7 +2476,7 @@ static Handle<Value> stream_next(const Arguments& args)
         return ThrowException(String::New("Exception: Stream.next() accepts no argument"));
 
     void *data = args.This()->GetPointerFromInternalField(0);
-    std::fstream *fs = reinterpret_cast<std::fstream*>(data);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
 
     std::string buffer;
     std::getline(*fs, buffer);
@@ -322,7 +2492,7 @@ static Handle<Value> stream_readLine(const Arguments& args)
         return ThrowException(String::New("Exception: Stream.readLine() accepts no argument"));
 
     void *data = args.This()->GetPointerFromInternalField(0);
-    std::fstream *fs = reinterpret_cast<std::fstream*>(data);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
 
     if (fs->eof())
         return String::NewSymbol("");
@@ -334,13 +2504,207 @@ static Handle<Value> stream_readLine(const Arguments& args)
     return String::New(buffer.c_str());
 }
 
+static Handle<Value> stream_read(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: Stream.read() accepts no argument"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+
+    std::string content;
+    char buffer[64 * 1024];
+    while (fs->read(buffer, sizeof(buffer)) || fs->gcount() > 0)
+        content.append(buffer, fs->gcount());
+
+    return handle_scope.Close(String::New(content.c_str(), content.size()));
+}
+
+static Handle<Value> stream_readLines(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: Stream.readLines() accepts no argument"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+
+    Handle<Array> lines = Array::New();
+    int count = 0;
+    std::string line;
+    while (std::getline(*fs, line))
+        lines->Set(count++, String::New(line.c_str(), line.size()));
+
+    return handle_scope.Close(lines);
+}
+
+// Returns the descriptor for the positioned functions, or -1 (with an
+// exception thrown) if the stream is compressed or closed.
+static int streamDescriptor(FileStream* fs, const char* function)
+{
+    if (fs->descriptor() < 0) {
+        std::string message = std::string("Exception: ") + function + " is not supported on a compressed or closed Stream";
+        ThrowException(String::New(message.c_str()));
+    }
+    return fs->descriptor();
+}
+
+static Handle<Value> stream_readAt(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 2)
+        return ThrowException(String::New("Exception: Stream.readAt() accepts 2 arguments"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+    int fd = streamDescriptor(fs, "Stream.readAt()");
+    if (fd < 0)
+        return Undefined();
+
+    double offset = args[0]->NumberValue();
+    double length = args[1]->NumberValue();
+    if (!(offset >= 0) || !(length >= 0))
+        return ThrowException(String::New("Exception: Stream.readAt() needs a non-negative offset and length"));
+
+    // Pending writes must reach the file first.
+    fs->flush();
+
+    // The buffer is sized from the caller's length, so it must not exceed
+    // what a regular file can return.
+    struct stat statbuf;
+    if (::fstat(fd, &statbuf) != 0)
+        return ThrowException(String::New("Exception: Stream.readAt() can't get the file size"));
+    if (S_ISREG(statbuf.st_mode)) {
+        double available = (offset < statbuf.st_size) ? statbuf.st_size - offset : 0;
+        length = std::min(length, available);
+    }
+
+    char* buffer = 0;
+    if (length >= 1) {
+        if (length < static_cast<double>(std::numeric_limits<size_t>::max()))
+            buffer = static_cast<char*>(malloc(static_cast<size_t>(length)));
+        if (!buffer)
+            return ThrowException(String::New("Exception: Stream.readAt() can't allocate the buffer"));
+    }
+
+    long long count = buffer ? readFileAt(fd, buffer, static_cast<size_t>(length), static_cast<long long>(offset)) : 0;
+    if (count < 0) {
+        free(buffer);
+        return ThrowException(String::New("Exception: Stream.readAt() can't read the file"));
+    }
+
+    Handle<String> result = String::New(buffer ? buffer : "", count);
+    free(buffer);
+    return handle_scope.Close(result);
+}
+
+static Handle<Value> stream_seek(const Arguments& args)
+{
+    if (args.Length() != 1)
+        return ThrowException(String::New("Exception: Stream.seek() accepts 1 argument"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+    if (streamDescriptor(fs, "Stream.seek()") < 0)
+        return Undefined();
+
+    double offset = args[0]->NumberValue();
+    if (!(offset >= 0))
+        return ThrowException(String::New("Exception: Stream.seek() needs a non-negative offset"));
+
+    fs->clear();
+    std::streampos position = static_cast<std::streamoff>(offset);
+    if (fs->rdbuf()->pubseekpos(position, std::ios::in | std::ios::out) != position)
+        return ThrowException(String::New("Exception: Stream.seek() can't move to the offset"));
+
+    return args.This();
+}
+
+static Handle<Value> stream_size(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: Stream.size() accepts no argument"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+    int fd = streamDescriptor(fs, "Stream.size()");
+    if (fd < 0)
+        return Undefined();
+
+    fs->flush();
+
+    struct stat statbuf;
+    if (::fstat(fd, &statbuf) != 0)
+        return ThrowException(String::New("Exception: Stream.size() can't get the file size"));
+
+    return handle_scope.Close(Number::New(static_cast<double>(statbuf.st_size)));
+}
+
+static Handle<Value> stream_tell(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: Stream.tell() accepts no argument"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+    if (streamDescriptor(fs, "Stream.tell()") < 0)
+        return Undefined();
+
+    std::streamoff position = fs->rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in | std::ios::out);
+    if (position < 0)
+        return ThrowException(String::New("Exception: Stream.tell() can't get the position"));
+
+    return handle_scope.Close(Number::New(static_cast<double>(position)));
+}
+
+static Handle<Value> stream_writeAt(const Arguments& args)
+{
+    if (args.Length() != 2)
+        return ThrowException(String::New("Exception: Stream.writeAt() accepts 2 arguments"));
+
+    void *data = args.This()->GetPointerFromInternalField(0);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
+    int fd = streamDescriptor(fs, "Stream.writeAt()");
+    if (fd < 0)
+        return Undefined();
+
+    double offset = args[0]->NumberValue();
+    if (!(offset >= 0))
+        return ThrowException(String::New("Exception: Stream.writeAt() needs a non-negative offset"));
+
+    fs->flush();
+
+    String::Utf8Value text(args[1]);
+    if (!writeFileAt(fd, *text, text.length(), static_cast<long long>(offset)))
+        return ThrowException(String::New("Exception: Stream.writeAt() can't write the file"));
+
+    // Seeking to the current position drops anything already buffered
+    // for reading, which may be stale now.
+    std::streampos position = fs->rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in | std::ios::out);
+    if (position >= 0)
+        fs->rdbuf()->pubseekpos(position, std::ios::in | std::ios::out);
+
+    String::Utf8Value name(args.This()->Get(String::New("name")));
+    invalidateFileStatus(*name);
+
+    return args.This();
+}
+
 static Handle<Value> stream_writeLine(const Arguments& args)
 {
     if (args.Length() != 1)
         return ThrowException(String::New("Exception: Stream.writeLine() accepts 1 argument"));
 
     void *data = args.This()->GetPointerFromInternalField(0);
-    std::fstream *fs = reinterpret_cast<std::fstream*>(data);
+    FileStream *fs = reinterpret_cast<FileStream*>(data);
 
     String::Utf8Value line(args[0]);
     fs->write(*line, line.length());
@@ -354,12 +2718,23 @@ void setup_fs(Handle<Object> object, Handle<Array> args)
     // 'fs' object
     Handle<FunctionTemplate> fsObject = FunctionTemplate::New();
     fsObject->Set(String::New("pathSeparator"), String::New(PATH_SEPARATOR), ReadOnly);
+    fsObject->Set(String::New("concat"), FunctionTemplate::New(fs_concat)->GetFunction());
+    fsObject->Set(String::New("copy"), FunctionTemplate::New(fs_copy)->GetFunction());
+    fsObject->Set(String::New("enableStatCache"), FunctionTemplate::New(fs_enableStatCache)->GetFunction());
     fsObject->Set(String::New("exists"), FunctionTemplate::New(fs_exists)->GetFunction());
+    fsObject->Set(String::New("invalidateStatCache"), FunctionTemplate::New(fs_invalidateStatCache)->GetFunction());
     fsObject->Set(String::New("makeDirectory"), FunctionTemplate::New(fs_makeDirectory)->GetFunction());
+    fsObject->Set(String::New("glob"), FunctionTemplate::New(fs_glob)->GetFunction());
+    fsObject->Set(String::New("hash"), FunctionTemplate::New(fs_hash)->GetFunction());
     fsObject->Set(String::New("isDirectory"), FunctionTemplate::New(fs_isDirectory)->GetFunction());
     fsObject->Set(String::New("isFile"), FunctionTemplate::New(fs_isFile)->GetFunction());
     fsObject->Set(String::New("list"), FunctionTemplate::New(fs_list)->GetFunction());
     fsObject->Set(String::New("open"), FunctionTemplate::New(fs_open)->GetFunction());
+    fsObject->Set(String::New("readCSV"), FunctionTemplate::New(fs_readCSV)->GetFunction());
+    fsObject->Set(String::New("readJSON"), FunctionTemplate::New(fs_readJSON)->GetFunction());
+    fsObject->Set(String::New("readJSONLines"), FunctionTemplate::New(fs_readJSONLines)->GetFunction());
+    fsObject->Set(String::New("stat"), FunctionTemplate::New(fs_stat)->GetFunction());
+    fsObject->Set(String::New("watch"), FunctionTemplate::New(fs_watch)->GetFunction());
     fsObject->Set(String::New("workingDirectory"), FunctionTemplate::New(fs_workingDirectory)->GetFunction());
 
     // 'Stream' class
@@ -369,7 +2744,14 @@ void setup_fs(Handle<Object> object, Handle<Array> args)
     streamClass->InstanceTemplate()->Set(String::New("close"), FunctionTemplate::New(stream_close)->GetFunction());
     streamClass->InstanceTemplate()->Set(String::New("flush"), FunctionTemplate::New(stream_flush)->GetFunction());
     streamClass->InstanceTemplate()->Set(String::New("next"), FunctionTemplate::New(stream_next)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("read"), FunctionTemplate::New(stream_read)->GetFunction());
     streamClass->InstanceTemplate()->Set(String::New("readLine"), FunctionTemplate::New(stream_readLine)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("readAt"), FunctionTemplate::New(stream_readAt)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("readLines"), FunctionTemplate::New(stream_readLines)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("seek"), FunctionTemplate::New(stream_seek)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("size"), FunctionTemplate::New(stream_size)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("tell"), FunctionTemplate::New(stream_tell)->GetFunction());
+    streamClass->InstanceTemplate()->Set(String::New("writeAt"), FunctionTemplate::New(stream_writeAt)->GetFunction());
     streamClass->InstanceTemplate()->Set(String::New("writeLine"), FunctionTemplate::New(stream_writeLine)->GetFunction());
 
     object->Set(String::New("fs"), fsObject->GetFunction());
@@ -0,0 +1,414 @@
+/*
+    Copyright (c) 2011 Sencha Inc.
+    Copyright (c) 2010 Sencha Inc.
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "hash.h"
+
+#if defined(WIN32) || defined(_WIN32)
+#define HAMMERJS_OS_WINDOWS
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(HAMMERJS_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static const size_t fileBufferSize = 256 * 1024;
+
+static std::string toHex(const unsigned char* bytes, size_t length)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string result(length * 2, '0');
+    for (size_t i = 0; i < length; ++i) {
+        result[2 * i] = digits[bytes[i] >> 4];
+        result[2 * i + 1] = digits[bytes[i] & 15];
+    }
+    return result;
+}
+
+// SHA-256, as specified in FIPS 180-4.
+class SHA256Hasher : public Hasher {
+public:
+    SHA256Hasher()
+        : m_length(0)
+        , m_bufferLength(0)
+    {
+        static const uint32_t initial[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        memcpy(m_state, initial, sizeof(m_state));
+    }
+
+    void update(const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        m_length += length;
+        if (m_bufferLength) {
+            size_t count = std::min(length, sizeof(m_buffer) - m_bufferLength);
+            memcpy(m_buffer + m_bufferLength, bytes, count);
+            m_bufferLength += count;
+            bytes += count;
+            length -= count;
+            if (m_bufferLength < sizeof(m_buffer))
+                return;
+            transform(m_buffer);
+            m_bufferLength = 0;
+        }
+        for (; length >= 64; bytes += 64, length -= 64)
+            transform(bytes);
+        memcpy(m_buffer, bytes, length);
+        m_bufferLength = length;
+    }
+
+    std::string digest()
+    {
+        uint64_t bits = m_length * 8;
+        unsigned char padding[72];
+        memset(padding, 0, sizeof(padding));
+        padding[0] = 0x80;
+        size_t count = (m_bufferLength < 56) ? (56 - m_bufferLength) : (120 - m_bufferLength);
+        for (int i = 0; i < 8; ++i)
+            padding[count + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        update(padding, count + 8);
+
+        unsigned char result[32];
+        for (int i = 0; i < 8; ++i) {
+            result[4 * i] = m_state[i] >> 24;
+            result[4 * i + 1] = m_state[i] >> 16;
+            result[4 * i + 2] = m_state[i] >> 8;
+            result[4 * i + 3] = m_state[i];
+        }
+        return toHex(result, sizeof(result));
+    }
+
+private:
+    static uint32_t rotate(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void transform(const unsigned char* block)
+    {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = (block[4 * i] << 24) | (block[4 * i + 1] << 16) | (block[4 * i + 2] << 8) | block[4 * i + 3];
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+        uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+        m_state[5] += f;
+        m_state[6] += g;
+        m_state[7] += h;
+    }
+
+    uint32_t m_state[8];
+    uint64_t m_length;
+    unsigned char m_buffer[64];
+    size_t m_bufferLength;
+};
+
+// XXH64 (seed 0), a fast non-cryptographic hash. See
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+class XXH64Hasher : public Hasher {
+public:
+    XXH64Hasher()
+        : m_length(0)
+        , m_bufferLength(0)
+    {
+        m_state[0] = prime1 + prime2;
+        m_state[1] = prime2;
+        m_state[2] = 0;
+        m_state[3] = 0 - prime1;
+    }
+
+    void update(const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        m_length += length;
+        if (m_bufferLength) {
+            size_t count = std::min(length, sizeof(m_buffer) - m_bufferLength);
+            memcpy(m_buffer + m_bufferLength, bytes, count);
+            m_bufferLength += count;
+            bytes += count;
+            length -= count;
+            if (m_bufferLength < sizeof(m_buffer))
+                return;
+            consume(m_buffer);
+            m_bufferLength = 0;
+        }
+        for (; length >= 32; bytes += 32, length -= 32)
+            consume(bytes);
+        memcpy(m_buffer, bytes, length);
+        m_bufferLength = length;
+    }
+
+    std::string digest()
+    {
+        uint64_t h;
+        if (m_length >= 32) {
+            h = rotate(m_state[0], 1) + rotate(m_state[1], 7) + rotate(m_state[2], 12) + rotate(m_state[3], 18);
+            for (int i = 0; i < 4; ++i)
+                h = (h ^ round(0, m_state[i])) * prime1 + prime4;
+        } else {
+            h = prime5;
+        }
+        h += m_length;
+
+        const unsigned char* p = m_buffer;
+        const unsigned char* end = m_buffer + m_bufferLength;
+        for (; p + 8 <= end; p += 8)
+            h = rotate(h ^ round(0, read64(p)), 27) * prime1 + prime4;
+        if (p + 4 <= end) {
+            h = rotate(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+            p += 4;
+        }
+        for (; p < end; ++p)
+            h = rotate(h ^ (*p * prime5), 11) * prime1;
+
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        h *= prime3;
+        h ^= h >> 32;
+
+        unsigned char result[8];
+        for (int i = 0; i < 8; ++i)
+            result[i] = static_cast<unsigned char>(h >> (56 - 8 * i));
+        return toHex(result, sizeof(result));
+    }
+
+private:
+    static const uint64_t prime1 = 11400714785074694791ULL;
+    static const uint64_t prime2 = 14029467366897019727ULL;
+    static const uint64_t prime3 = 1609587929392839161ULL;
+    static const uint64_t prime4 = 9650029242287828579ULL;
+    static const uint64_t prime5 = 2870177450012600261ULL;
+
+    static uint64_t rotate(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+    static uint64_t read64(const unsigned char* p)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i)
+            value = (value << 8) | p[i];
+        return value;
+    }
+
+    static uint64_t read32(const unsigned char* p)
+    {
+        return static_cast<uint64_t>(p[0]) | (p[1] << 8) | (p[2] << 16) | (static_cast<uint64_t>(p[3]) << 24);
+    }
+
+    static uint64_t round(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * prime2;
+        return rotate(accumulator, 31) * prime1;
+    }
+
+    void consume(const unsigned char* block)
+    {
+        for (int i = 0; i < 4; ++i)
+            m_state[i] = round(m_state[i], read64(block + 8 * i));
+    }
+
+    uint64_t m_state[4];
+    uint64_t m_length;
+    unsigned char m_buffer[32];
+    size_t m_bufferLength;
+};
+
+Hasher* Hasher::create(const char* algorithm)
+{
+    if (!strcmp(algorithm, "sha256"))
+        return new SHA256Hasher;
+    if (!strcmp(algorithm, "xxh64"))
+        return new XXH64Hasher;
+    return 0;
+}
+
+static bool hashFile(const char* fileName, const char* algorithm, std::string* digest, std::vector<char>& buffer)
+{
+    Hasher* hasher = Hasher::create(algorithm);
+    if (!hasher)
+        return false;
+
+    FILE* f = fopen(fileName, "rb");
+    if (!f) {
+        delete hasher;
+        return false;
+    }
+
+    size_t count;
+    while ((count = fread(&buffer[0], 1, buffer.size(), f)) > 0)
+        hasher->update(&buffer[0], count);
+    bool ok = !ferror(f);
+    fclose(f);
+
+    if (ok)
+        *digest = hasher->digest();
+    delete hasher;
+    return ok;
+}
+
+bool hashFile(const char* fileName, const char* algorithm, std::string* digest)
+{
+    std::vector<char> buffer(fileBufferSize);
+    return hashFile(fileName, algorithm, digest, buffer);
+}
+
+// Work shared by the hashFiles() threads: each one repeatedly takes the
+// next unclaimed file until all of them are done.
+struct HashJob {
+    const std::vector<std::string>* fileNames;
+    const char* algorithm;
+    std::vector<std::string>* digests;
+    size_t next;
+#if defined(HAMMERJS_OS_WINDOWS)
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+static size_t takeFile(HashJob* job)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    EnterCriticalSection(&job->lock);
+    size_t index = job->next++;
+    LeaveCriticalSection(&job->lock);
+#else
+    pthread_mutex_lock(&job->lock);
+    size_t index = job->next++;
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return index;
+}
+
+#if defined(HAMMERJS_OS_WINDOWS)
+static DWORD WINAPI hashWorker(LPVOID data)
+#else
+static void* hashWorker(void* data)
+#endif
+{
+    HashJob* job = static_cast<HashJob*>(data);
+    std::vector<char> buffer(fileBufferSize);
+    for (size_t index = takeFile(job); index < job->fileNames->size(); index = takeFile(job))
+        hashFile((*job->fileNames)[index].c_str(), job->algorithm, &(*job->digests)[index], buffer);
+    return 0;
+}
+
+static size_t processorCount()
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? count : 1;
+#endif
+}
+
+void hashFiles(const std::vector<std::string>& fileNames, const char* algorithm, std::vector<std::string>* digests)
+{
+    digests->assign(fileNames.size(), std::string());
+
+    HashJob job;
+    job.fileNames = &fileNames;
+    job.algorithm = algorithm;
+    job.digests = digests;
+    job.next = 0;
+
+    // The calling thread is one of the workers.
+    size_t threadCount = std::min(processorCount(), fileNames.size());
+    if (threadCount <= 1) {
+        std::vector<char> buffer(fileBufferSize);
+        for (size_t i = 0; i < fileNames.size(); ++i)
+            hashFile(fileNames[i].c_str(), algorithm, &(*digests)[i], buffer);
+        return;
+    }
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    InitializeCriticalSection(&job.lock);
+    std::vector<HANDLE> threads;
+    for (size_t i = 1; i < threadCount; ++i) {
+        HANDLE thread = CreateThread(NULL, 0, hashWorker, &job, 0, NULL);
+        if (thread)
+            threads.push_back(thread);
+    }
+    hashWorker(&job);
+    for (size_t i = 0; i < threads.size(); ++i) {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+    DeleteCriticalSection(&job.lock);
+#else
+    pthread_mutex_init(&job.lock, NULL);
+    std::vector<pthread_t> threads;
+    for (size_t i = 1; i < threadCount; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, hashWorker, &job) == 0)
+            threads.push_back(thread);
+    }
+    hashWorker(&job);
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&job.lock);
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+    Copyright (c) 2011 Sencha Inc.
+    Copyright (c) 2010 Sencha Inc.
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef HAMMERJS_HASH_H
+#define HAMMERJS_HASH_H
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+// Content hashing shared by fs.hash() and system.hash().
+// Supported algorithms are "sha256" and "xxh64".
+
+class Hasher {
+public:
+    virtual ~Hasher() { }
+
+    virtual void update(const void* data, size_t length) = 0;
+
+    // Returns the digest as a lowercase hexadecimal string.
+    virtual std::string digest() = 0;
+
+    // Returns 0 if the algorithm is not supported.
+    static Hasher* create(const char* algorithm);
+};
+
+// Streams the file through a fixed-size buffer. Returns false if the file
+// can not be read (or the algorithm is not supported).
+bool hashFile(const char* fileName, const char* algorithm, std::string* digest);
+
+// Hashes all the files using a pool of worker threads. The digest of a file
+// which can not be read is left empty.
+void hashFiles(const std::vector<std::string>& fileNames, const char* algorithm, std::vector<std::string>* digests);
+
+#endif // HAMMERJS_HASH_H
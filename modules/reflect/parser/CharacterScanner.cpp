@@ -0,0 +1,500 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "CharacterScanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The vector paths rely on per-function target attributes, so the rest of the
+// library keeps building for the baseline instruction set.
+#if COMPILER(GCC) && (CPU(X86) || CPU(X86_64)) && (GCC_VERSION_AT_LEAST(4, 9, 0) || defined(__clang__))
+#define REFLECT_SIMD_SCANNER 1
+#include <immintrin.h>
+#endif
+
+namespace JSC {
+
+static inline bool isScannerLineTerminator(UChar c)
+{
+    return c == '\n' || c == '\r' || (c & ~1) == 0x2028;
+}
+
+static inline bool isScannerIdentifierPart(UChar c)
+{
+    return static_cast<unsigned>((c | 0x20) - 'a') < 26 || static_cast<unsigned>(c - '0') < 10 || c == '_' || c == '$';
+}
+
+template <typename CharType>
+static const CharType* skipSpacesScalar(const CharType* p, const CharType* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    return p;
+}
+
+template <typename CharType>
+static const CharType* findLineTerminatorScalar(const CharType* p, const CharType* end)
+{
+    while (p < end && !isScannerLineTerminator(*p))
+        ++p;
+    return p;
+}
+
+template <typename CharType>
+static const CharType* findCommentSpecialScalar(const CharType* p, const CharType* end)
+{
+    while (p < end && *p != '*' && !isScannerLineTerminator(*p))
+        ++p;
+    return p;
+}
+
+template <typename CharType>
+static const CharType* findStringSpecialScalar(const CharType* p, const CharType* end, CharType quote)
+{
+    while (p < end && *p != quote && *p != '\\' && !isScannerLineTerminator(*p))
+        ++p;
+    return p;
+}
+
+template <typename CharType>
+static const CharType* skipIdentifierPartScalar(const CharType* p, const CharType* end)
+{
+    while (p < end && isScannerIdentifierPart(*p))
+        ++p;
+    return p;
+}
+
+#if defined(REFLECT_SIMD_SCANNER)
+
+// movemask yields two bits per 16-bit lane.
+static inline unsigned firstLane(unsigned mask)
+{
+    return __builtin_ctz(mask) >> 1;
+}
+
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+
+SSE2_FUNCTION static inline __m128i lineTerminatorMask16x8(__m128i c)
+{
+    __m128i separator = _mm_cmpeq_epi16(_mm_and_si128(c, _mm_set1_epi16(static_cast<short>(0xFFFE))), _mm_set1_epi16(0x2028));
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16('\n')), _mm_cmpeq_epi16(c, _mm_set1_epi16('\r'))), separator);
+}
+
+SSE2_FUNCTION static inline __m128i identifierPartMask16x8(__m128i c)
+{
+    // Lanes at or above 0x8000 compare as negative and fall out of both ranges.
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi16(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi16(lower, _mm_set1_epi16('a' - 1)), _mm_cmplt_epi16(lower, _mm_set1_epi16('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi16(c, _mm_set1_epi16('0' - 1)), _mm_cmplt_epi16(c, _mm_set1_epi16('9' + 1)));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16('_')), _mm_cmpeq_epi16(c, _mm_set1_epi16('$')));
+    return _mm_or_si128(_mm_or_si128(letter, digit), other);
+}
+
+SSE2_FUNCTION static const UChar* skipSpacesSSE2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 8; p += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16(' ')), _mm_cmpeq_epi16(c, _mm_set1_epi16('\t')));
+        unsigned mask = ~_mm_movemask_epi8(space) & 0xFFFF;
+        if (mask)
+            return p + firstLane(mask);
+    }
+    return skipSpacesScalar(p, end);
+}
+
+SSE2_FUNCTION static const UChar* findLineTerminatorSSE2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 8; p += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (unsigned mask = _mm_movemask_epi8(lineTerminatorMask16x8(c)))
+            return p + firstLane(mask);
+    }
+    return findLineTerminatorScalar(p, end);
+}
+
+SSE2_FUNCTION static const UChar* findCommentSpecialSSE2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 8; p += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(lineTerminatorMask16x8(c), _mm_cmpeq_epi16(c, _mm_set1_epi16('*')));
+        if (unsigned mask = _mm_movemask_epi8(special))
+            return p + firstLane(mask);
+    }
+    return findCommentSpecialScalar(p, end);
+}
+
+SSE2_FUNCTION static const UChar* findStringSpecialSSE2(const UChar* p, const UChar* end, UChar quote)
+{
+    __m128i quotes = _mm_set1_epi16(quote);
+    for (; end - p >= 8; p += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi16(c, quotes), _mm_cmpeq_epi16(c, _mm_set1_epi16('\\')));
+        if (unsigned mask = _mm_movemask_epi8(_mm_or_si128(special, lineTerminatorMask16x8(c))))
+            return p + firstLane(mask);
+    }
+    return findStringSpecialScalar(p, end, quote);
+}
+
+SSE2_FUNCTION static const UChar* skipIdentifierPartSSE2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 8; p += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = ~_mm_movemask_epi8(identifierPartMask16x8(c)) & 0xFFFF;
+        if (mask)
+            return p + firstLane(mask);
+    }
+    return skipIdentifierPartScalar(p, end);
+}
+
+AVX2_FUNCTION static inline __m256i lineTerminatorMask16x16(__m256i c)
+{
+    __m256i separator = _mm256_cmpeq_epi16(_mm256_and_si256(c, _mm256_set1_epi16(static_cast<short>(0xFFFE))), _mm256_set1_epi16(0x2028));
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(c, _mm256_set1_epi16('\n')), _mm256_cmpeq_epi16(c, _mm256_set1_epi16('\r'))), separator);
+}
+
+AVX2_FUNCTION static inline __m256i identifierPartMask16x16(__m256i c)
+{
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi16(0x20));
+    __m256i letter = _mm256_andnot_si256(_mm256_cmpgt_epi16(lower, _mm256_set1_epi16('z')), _mm256_cmpgt_epi16(lower, _mm256_set1_epi16('a' - 1)));
+    __m256i digit = _mm256_andnot_si256(_mm256_cmpgt_epi16(c, _mm256_set1_epi16('9')), _mm256_cmpgt_epi16(c, _mm256_set1_epi16('0' - 1)));
+    __m256i other = _mm256_or_si256(_mm256_cmpeq_epi16(c, _mm256_set1_epi16('_')), _mm256_cmpeq_epi16(c, _mm256_set1_epi16('$')));
+    return _mm256_or_si256(_mm256_or_si256(letter, digit), other);
+}
+
+// The AVX2 loops hand the final partial block to their SSE2 counterparts.
+// Returning with dirty upper halves would slow down every SSE instruction
+// that follows in the rest of the program, so every exit clears them.
+AVX2_FUNCTION static inline const UChar* leaveAVX(const UChar* result)
+{
+    _mm256_zeroupper();
+    return result;
+}
+
+AVX2_FUNCTION static const UChar* skipSpacesAVX2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi16(c, _mm256_set1_epi16(' ')), _mm256_cmpeq_epi16(c, _mm256_set1_epi16('\t')));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        if (mask)
+            return leaveAVX(p + firstLane(mask));
+    }
+    _mm256_zeroupper();
+    return skipSpacesSSE2(p, end);
+}
+
+AVX2_FUNCTION static const UChar* findLineTerminatorAVX2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (unsigned mask = _mm256_movemask_epi8(lineTerminatorMask16x16(c)))
+            return leaveAVX(p + firstLane(mask));
+    }
+    _mm256_zeroupper();
+    return findLineTerminatorSSE2(p, end);
+}
+
+AVX2_FUNCTION static const UChar* findCommentSpecialAVX2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(lineTerminatorMask16x16(c), _mm256_cmpeq_epi16(c, _mm256_set1_epi16('*')));
+        if (unsigned mask = _mm256_movemask_epi8(special))
+            return leaveAVX(p + firstLane(mask));
+    }
+    _mm256_zeroupper();
+    return findCommentSpecialSSE2(p, end);
+}
+
+AVX2_FUNCTION static const UChar* findStringSpecialAVX2(const UChar* p, const UChar* end, UChar quote)
+{
+    __m256i quotes = _mm256_set1_epi16(quote);
+    for (; end - p >= 16; p += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi16(c, quotes), _mm256_cmpeq_epi16(c, _mm256_set1_epi16('\\')));
+        if (unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(special, lineTerminatorMask16x16(c))))
+            return leaveAVX(p + firstLane(mask));
+    }
+    _mm256_zeroupper();
+    return findStringSpecialSSE2(p, end, quote);
+}
+
+AVX2_FUNCTION static const UChar* skipIdentifierPartAVX2(const UChar* p, const UChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(identifierPartMask16x16(c)));
+        if (mask)
+            return leaveAVX(p + firstLane(mask));
+    }
+    _mm256_zeroupper();
+    return skipIdentifierPartSSE2(p, end);
+}
+
+// Latin-1 source has no U+2028 or U+2029, and movemask yields one bit per
+// character. Bytes at or above 0x80 compare as negative, so they never
+// match the ASCII ranges below.
+
+SSE2_FUNCTION static inline __m128i lineTerminatorMask8x16(__m128i c)
+{
+    return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+}
+
+SSE2_FUNCTION static inline __m128i identifierPartMask8x16(__m128i c)
+{
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')), _mm_cmpeq_epi8(c, _mm_set1_epi8('$')));
+    return _mm_or_si128(_mm_or_si128(letter, digit), other);
+}
+
+SSE2_FUNCTION static const LChar* skipSpacesSSE2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+        unsigned mask = ~_mm_movemask_epi8(space) & 0xFFFF;
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return skipSpacesScalar(p, end);
+}
+
+SSE2_FUNCTION static const LChar* findLineTerminatorSSE2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (unsigned mask = _mm_movemask_epi8(lineTerminatorMask8x16(c)))
+            return p + __builtin_ctz(mask);
+    }
+    return findLineTerminatorScalar(p, end);
+}
+
+SSE2_FUNCTION static const LChar* findCommentSpecialSSE2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(lineTerminatorMask8x16(c), _mm_cmpeq_epi8(c, _mm_set1_epi8('*')));
+        if (unsigned mask = _mm_movemask_epi8(special))
+            return p + __builtin_ctz(mask);
+    }
+    return findCommentSpecialScalar(p, end);
+}
+
+SSE2_FUNCTION static const LChar* findStringSpecialSSE2(const LChar* p, const LChar* end, LChar quote)
+{
+    __m128i quotes = _mm_set1_epi8(quote);
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(c, quotes), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+        if (unsigned mask = _mm_movemask_epi8(_mm_or_si128(special, lineTerminatorMask8x16(c))))
+            return p + __builtin_ctz(mask);
+    }
+    return findStringSpecialScalar(p, end, quote);
+}
+
+SSE2_FUNCTION static const LChar* skipIdentifierPartSSE2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = ~_mm_movemask_epi8(identifierPartMask8x16(c)) & 0xFFFF;
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return skipIdentifierPartScalar(p, end);
+}
+
+AVX2_FUNCTION static inline __m256i lineTerminatorMask8x32(__m256i c)
+{
+    return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')));
+}
+
+AVX2_FUNCTION static inline __m256i identifierPartMask8x32(__m256i c)
+{
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_andnot_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('z')), _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)));
+    __m256i digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)));
+    __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('$')));
+    return _mm256_or_si256(_mm256_or_si256(letter, digit), other);
+}
+
+AVX2_FUNCTION static inline const LChar* leaveAVX(const LChar* result)
+{
+    _mm256_zeroupper();
+    return result;
+}
+
+AVX2_FUNCTION static const LChar* skipSpacesAVX2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t')));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        if (mask)
+            return leaveAVX(p + __builtin_ctz(mask));
+    }
+    _mm256_zeroupper();
+    return skipSpacesSSE2(p, end);
+}
+
+AVX2_FUNCTION static const LChar* findLineTerminatorAVX2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (unsigned mask = _mm256_movemask_epi8(lineTerminatorMask8x32(c)))
+            return leaveAVX(p + __builtin_ctz(mask));
+    }
+    _mm256_zeroupper();
+    return findLineTerminatorSSE2(p, end);
+}
+
+AVX2_FUNCTION static const LChar* findCommentSpecialAVX2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(lineTerminatorMask8x32(c), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('*')));
+        if (unsigned mask = _mm256_movemask_epi8(special))
+            return leaveAVX(p + __builtin_ctz(mask));
+    }
+    _mm256_zeroupper();
+    return findCommentSpecialSSE2(p, end);
+}
+
+AVX2_FUNCTION static const LChar* findStringSpecialAVX2(const LChar* p, const LChar* end, LChar quote)
+{
+    __m256i quotes = _mm256_set1_epi8(quote);
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(c, quotes), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+        if (unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(special, lineTerminatorMask8x32(c))))
+            return leaveAVX(p + __builtin_ctz(mask));
+    }
+    _mm256_zeroupper();
+    return findStringSpecialSSE2(p, end, quote);
+}
+
+AVX2_FUNCTION static const LChar* skipIdentifierPartAVX2(const LChar* p, const LChar* end)
+{
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(identifierPartMask8x32(c)));
+        if (mask)
+            return leaveAVX(p + __builtin_ctz(mask));
+    }
+    _mm256_zeroupper();
+    return skipIdentifierPartSSE2(p, end);
+}
+
+SSE2_FUNCTION static bool narrowToLatin1SSE2(const UChar* p, const UChar* end, LChar* destination)
+{
+    for (; end - p >= 16; p += 16, destination += 16) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+        __m128i upperBytes = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(static_cast<short>(0xFF00)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(upperBytes, _mm_setzero_si128())) != 0xFFFF)
+            return false;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(low, high));
+    }
+    for (; p < end; ++p, ++destination) {
+        if (*p > 0xFF)
+            return false;
+        *destination = static_cast<LChar>(*p);
+    }
+    return true;
+}
+
+#endif // defined(REFLECT_SIMD_SCANNER)
+
+enum ScannerLevel { ScalarScanner, SSE2Scanner, AVX2Scanner };
+
+static ScannerLevel selectScannerLevel()
+{
+    const char* limit = getenv("REFLECT_SCANNER");
+    if (limit && !strcmp(limit, "scalar"))
+        return ScalarScanner;
+#if defined(REFLECT_SIMD_SCANNER)
+    __builtin_cpu_init();
+    if ((!limit || strcmp(limit, "sse2")) && __builtin_cpu_supports("avx2"))
+        return AVX2Scanner;
+    if (__builtin_cpu_supports("sse2"))
+        return SSE2Scanner;
+#endif
+    return ScalarScanner;
+}
+
+// Selected while the program starts, before any thread can parse.
+static const ScannerLevel selectedScannerLevel = selectScannerLevel();
+
+static ScannerLevel scannerLevel()
+{
+    return selectedScannerLevel;
+}
+
+#if defined(REFLECT_SIMD_SCANNER)
+#define DEFINE_SCANNERS(CharType) \
+    static const CharacterScanner<CharType> scanners##CharType[] = { \
+        { skipSpacesScalar, findLineTerminatorScalar, findCommentSpecialScalar, findStringSpecialScalar, skipIdentifierPartScalar, "scalar" }, \
+        { skipSpacesSSE2, findLineTerminatorSSE2, findCommentSpecialSSE2, findStringSpecialSSE2, skipIdentifierPartSSE2, "sse2" }, \
+        { skipSpacesAVX2, findLineTerminatorAVX2, findCommentSpecialAVX2, findStringSpecialAVX2, skipIdentifierPartAVX2, "avx2" } \
+    };
+#else
+#define DEFINE_SCANNERS(CharType) \
+    static const CharacterScanner<CharType> scanners##CharType[] = { \
+        { skipSpacesScalar, findLineTerminatorScalar, findCommentSpecialScalar, findStringSpecialScalar, skipIdentifierPartScalar, "scalar" } \
+    };
+#endif
+
+DEFINE_SCANNERS(LChar)
+DEFINE_SCANNERS(UChar)
+
+template <> const CharacterScanner<LChar>& CharacterScanner<LChar>::get()
+{
+    return scannersLChar[scannerLevel()];
+}
+
+template <> const CharacterScanner<UChar>& CharacterScanner<UChar>::get()
+{
+    return scannersUChar[scannerLevel()];
+}
+
+bool narrowToLatin1(const UChar* begin, const UChar* end, LChar* destination)
+{
+#if defined(REFLECT_SIMD_SCANNER)
+    if (scannerLevel() != ScalarScanner)
+        return narrowToLatin1SSE2(begin, end, destination);
+#endif
+    for (; begin < end; ++begin, ++destination) {
+        if (*begin > 0xFF)
+            return false;
+        *destination = static_cast<LChar>(*begin);
+    }
+    return true;
+}
+
+} // namespace JSC
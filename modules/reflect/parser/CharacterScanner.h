@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2010 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL APPLE INC. OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CharacterScanner_h
+#define CharacterScanner_h
+
+#include <wtf/Platform.h>
+
+namespace JSC {
+
+    // Bulk scanning primitives for the lexer's innermost loops, for Latin-1
+    // and for UTF-16 source. Every function returns the first character in
+    // [begin, end) that stops the scan, or end.
+    //
+    // The implementation is chosen once per process: AVX2 or SSE2 on x86 when
+    // the processor supports it, plain loops everywhere else. Setting the
+    // REFLECT_SCANNER environment variable to "scalar", "sse2" or "avx2" caps
+    // the selection, which is how the vector paths are compared against the
+    // scalar one.
+    template <typename CharType>
+    struct CharacterScanner {
+        typedef const CharType* (*ScanFunction)(const CharType* begin, const CharType* end);
+        typedef const CharType* (*QuoteScanFunction)(const CharType* begin, const CharType* end, CharType quote);
+
+        // Stops at anything but ' ' and '\t'.
+        ScanFunction skipSpaces;
+        // Stops at '\n', '\r', U+2028 and U+2029.
+        ScanFunction findLineTerminator;
+        // Stops at '*' or a line terminator.
+        ScanFunction findCommentSpecial;
+        // Stops at the quote, '\\' or a line terminator.
+        QuoteScanFunction findStringSpecial;
+        // Stops at anything but [A-Za-z0-9_$]; the lexer handles the rest.
+        ScanFunction skipIdentifierPart;
+
+        const char* name;
+
+        static const CharacterScanner& get();
+    };
+
+    template <> const CharacterScanner<LChar>& CharacterScanner<LChar>::get();
+    template <> const CharacterScanner<UChar>& CharacterScanner<UChar>::get();
+
+    // Copies [begin, end) to destination as Latin-1 and returns true, or
+    // returns false at the first character above U+00FF, leaving destination
+    // partly written. destination may alias begin, which narrows in place.
+    bool narrowToLatin1(const UChar* begin, const UChar* end, LChar* destination);
+
+} // namespace JSC
+
+#endif // CharacterScanner_h
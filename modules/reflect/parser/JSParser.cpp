@@ -32,6 +32,8 @@ using namespace JSC;
 #include "Identifier.h"
 #include "JSGlobalData.h"
 #include "SyntaxTree.h"
+#include <map>
+#include <string.h>
 #include <utility>
 
 using namespace std;
@@ -63,9 +65,13 @@ COMPILE_ASSERT(LastUntaggedToken < 64, LessThan64UntaggedTokens);
 // This matches v8
 static const ptrdiff_t kMaxParserStackUsage = 128 * sizeof(void*) * 1024;
 
+enum FunctionRequirements { FunctionNoRequirements, FunctionNeedsName };
+
+// LexerType is Lexer<LChar> or Lexer<UChar>, matching the source's width.
+template <typename LexerType>
 class JSParser {
 public:
-    JSParser(Lexer*, JSGlobalData*, SourceProvider*);
+    JSParser(LexerType*, JSGlobalData*, SourceProvider*);
     void* createSyntaxTree();
 private:
     struct AllowInOverride {
@@ -83,7 +89,7 @@ private:
         bool m_oldAllowsIn;
     };
 
-    void next(Lexer::LexType lexType = Lexer::IdentifyReservedWords)
+    void next(LexType lexType = IdentifyReservedWords)
     {
         m_lastLine = m_token.m_info.line;
         m_lastTokenEnd = m_token.m_info.endOffset;
@@ -158,7 +164,6 @@ private:
     template <class TreeBuilder> ALWAYS_INLINE TreeFormalParameterList parseFormalParameters(TreeBuilder&, bool& usesArguments);
     template <class TreeBuilder> ALWAYS_INLINE TreeExpression parseVarDeclarationList(TreeBuilder&, int& declarations, const Identifier*& lastIdent, TreeExpression& lastInitializer, int& identStart, int& initStart, int& initEnd);
     template <class TreeBuilder> ALWAYS_INLINE TreeConstDeclList parseConstDeclarationList(TreeBuilder& context);
-    enum FunctionRequirements { FunctionNoRequirements, FunctionNeedsName };
     template <FunctionRequirements, class TreeBuilder> bool parseFunctionInfo(TreeBuilder&, const Identifier*&, TreeFormalParameterList&, TreeFunctionBody&, int& openBrace, int& closeBrace, int& bodyStartLine);
     ALWAYS_INLINE int isBinaryOperator(JSTokenType token);
     bool allowAutomaticSemicolon();
@@ -182,8 +187,7 @@ private:
         return m_lastTokenEnd;
     }
 
-    ParserArena m_arena;
-    Lexer* m_lexer;
+    LexerType* m_lexer;
     bool m_error;
     JSGlobalData* m_globalData;
     JSToken m_token;
@@ -198,11 +202,16 @@ private:
 
 void* jsCreateSyntaxTree(JSGlobalData* globalData, const SourceCode* source)
 {
-    JSParser parser(globalData->lexer, globalData, source->provider());
+    if (source->provider()->is8Bit()) {
+        JSParser<Lexer<LChar> > parser(globalData->lexer8, globalData, source->provider());
+        return parser.createSyntaxTree();
+    }
+    JSParser<Lexer<UChar> > parser(globalData->lexer16, globalData, source->provider());
     return parser.createSyntaxTree();
 }
 
-JSParser::JSParser(Lexer* lexer, JSGlobalData* globalData, SourceProvider* provider)
+template <typename LexerType>
+JSParser<LexerType>::JSParser(LexerType* lexer, JSGlobalData* globalData, SourceProvider* provider)
     : m_lexer(lexer)
     , m_error(false)
     , m_globalData(globalData)
@@ -218,30 +227,35 @@ JSParser::JSParser(Lexer* lexer, JSGlobalData* globalData, SourceProvider* provi
     m_lexer->setLastLineNumber(tokenLine());
 }
 
-void* JSParser::createSyntaxTree()
+template <typename LexerType>
+void* JSParser<LexerType>::createSyntaxTree()
 {
-    SyntaxTree::Builder context(m_globalData, m_lexer);
+    SyntaxTree::Builder context(m_globalData);
     SyntaxTree::Node* programNode = parseSourceElements<SyntaxTree::Builder>(context);
     return programNode;
 }
 
-bool JSParser::allowAutomaticSemicolon()
+template <typename LexerType>
+bool JSParser<LexerType>::allowAutomaticSemicolon()
 {
     return match(CLOSEBRACE) || match(EOFTOK) || m_lexer->prevTerminator();
 }
 
-template <class TreeBuilder> TreeSourceElements JSParser::parseSourceElements(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeSourceElements JSParser<LexerType>::parseSourceElements(TreeBuilder& context)
 {
+    int start = tokenStart();
     TreeSourceElements sourceElements = context.createSourceElements();
     while (TreeStatement statement = parseStatement(context))
         context.appendStatement(sourceElements, statement);
 
     if (m_error)
         fail();
-    return sourceElements;
+    return context.setRange(sourceElements, start, lastTokenEnd());
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseVarDeclaration(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseVarDeclaration(TreeBuilder& context)
 {
     ASSERT(match(VAR));
     int start = tokenLine();
@@ -258,7 +272,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseVarDeclaration(TreeBui
     return context.createVarStatement(varDecls, start, end);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseConstDeclaration(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseConstDeclaration(TreeBuilder& context)
 {
     ASSERT(match(CONSTTOKEN));
     int start = tokenLine();
@@ -270,7 +285,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseConstDeclaration(TreeB
     return context.createConstStatement(constDecls, start, end);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseDoWhileStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseDoWhileStatement(TreeBuilder& context)
 {
     ASSERT(match(DO));
     int startLine = tokenLine();
@@ -288,7 +304,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseDoWhileStatement(TreeB
     return context.createDoWhileStatement(statement, expr, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseWhileStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseWhileStatement(TreeBuilder& context)
 {
     ASSERT(match(WHILE));
     int startLine = tokenLine();
@@ -303,15 +320,20 @@ template <class TreeBuilder> TreeStatement JSParser::parseWhileStatement(TreeBui
     return context.createWhileStatement(expr, statement, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseVarDeclarationList(TreeBuilder& context, int& declarations, const Identifier*& lastIdent, TreeExpression& lastInitializer, int& identStart, int& initStart, int& initEnd)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseVarDeclarationList(TreeBuilder& context, int& declarations, const Identifier*& lastIdent, TreeExpression& lastInitializer, int& identStart, int& initStart, int& initEnd)
 {
     TreeExpression varDecls = 0;
+    int start = -1;
     do {
         declarations++;
         next();
         matchOrFail(IDENT);
 
         int varStart = tokenStart();
+        int varEnd = tokenEnd();
+        if (start < 0)
+            start = varStart;
         identStart = varStart;
         const Identifier* name = m_token.m_data.ident;
         lastIdent = name;
@@ -328,24 +350,25 @@ template <class TreeBuilder> TreeExpression JSParser::parseVarDeclarationList(Tr
             lastInitializer = initializer;
             failIfFalse(initializer);
 
-            TreeExpression node = context.createAssignResolve(*name, initializer, initialAssignments != m_assignmentCount, varStart, varDivot, lastTokenEnd());
+            TreeExpression node = context.createAssignResolve(*name, initializer, initialAssignments != m_assignmentCount, varStart, varEnd, varDivot, lastTokenEnd());
             if (!varDecls)
                 varDecls = node;
             else
                 varDecls = context.combineCommaNodes(varDecls, node);
         } else {
             // FIXME: create a flag whether to do this or not
-            TreeExpression node = context.createVarIdentifier(name);
+            TreeExpression node = context.setRange(context.createVarIdentifier(name), varStart, varEnd);
             if (!varDecls)
                 varDecls = node;
             else
                 varDecls = context.combineCommaNodes(varDecls, node);
         }
     } while (match(COMMA));
-    return varDecls;
+    return context.setRange(varDecls, start, lastTokenEnd());
 }
 
-template <class TreeBuilder> TreeConstDeclList JSParser::parseConstDeclarationList(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeConstDeclList JSParser<LexerType>::parseConstDeclarationList(TreeBuilder& context)
 {
     TreeConstDeclList constDecls = 0;
     TreeConstDeclList tail = 0;
@@ -368,7 +391,8 @@ template <class TreeBuilder> TreeConstDeclList JSParser::parseConstDeclarationLi
     return constDecls;
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseForStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseForStatement(TreeBuilder& context)
 {
     ASSERT(match(FOR));
     int startLine = tokenLine();
@@ -466,7 +490,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseForStatement(TreeBuild
     return context.createForInLoop(decls, expr, statement, declsStart, declsEnd, exprEnd, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseBreakStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseBreakStatement(TreeBuilder& context)
 {
     ASSERT(match(BREAK));
     int startCol = tokenStart();
@@ -486,7 +511,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseBreakStatement(TreeBui
     return context.createBreakStatement(ident, startCol, endCol, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseContinueStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseContinueStatement(TreeBuilder& context)
 {
     ASSERT(match(CONTINUE));
     int startCol = tokenStart();
@@ -506,7 +532,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseContinueStatement(Tree
     return context.createContinueStatement(ident, startCol, endCol, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseReturnStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseReturnStatement(TreeBuilder& context)
 {
     ASSERT(match(RETURN));
     int startLine = tokenLine();
@@ -530,7 +557,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseReturnStatement(TreeBu
     return context.createReturnStatement(expr, start, end, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseThrowStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseThrowStatement(TreeBuilder& context)
 {
     ASSERT(match(THROW));
     int eStart = tokenStart();
@@ -546,7 +574,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseThrowStatement(TreeBui
     return context.createThrowStatement(expr, eStart, eEnd, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseWithStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseWithStatement(TreeBuilder& context)
 {
     ASSERT(match(WITH));
     int startLine = tokenLine();
@@ -566,7 +595,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseWithStatement(TreeBuil
     return context.createWithStatement(expr, statement, start, end, startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseSwitchStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseSwitchStatement(TreeBuilder& context)
 {
     ASSERT(match(SWITCH));
     int startLine = tokenLine();
@@ -592,45 +622,51 @@ template <class TreeBuilder> TreeStatement JSParser::parseSwitchStatement(TreeBu
 
 }
 
-template <class TreeBuilder> TreeClauseList JSParser::parseSwitchClauses(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeClauseList JSParser<LexerType>::parseSwitchClauses(TreeBuilder& context)
 {
     if (!match(CASE))
         return 0;
+    int start = tokenStart();
     next();
     TreeExpression condition = parseExpression(context);
     failIfFalse(condition);
     consumeOrFail(COLON);
     TreeSourceElements statements = parseSourceElements(context);
     failIfFalse(statements);
-    TreeClause clause = context.createClause(condition, statements);
+    TreeClause clause = context.setRange(context.createClause(condition, statements), start, lastTokenEnd());
     TreeClauseList clauseList = context.createClauseList(clause);
     TreeClauseList tail = clauseList;
 
     while (match(CASE)) {
+        start = tokenStart();
         next();
         TreeExpression condition = parseExpression(context);
         failIfFalse(condition);
         consumeOrFail(COLON);
         TreeSourceElements statements = parseSourceElements(context);
         failIfFalse(statements);
-        clause = context.createClause(condition, statements);
+        clause = context.setRange(context.createClause(condition, statements), start, lastTokenEnd());
         tail = context.createClauseList(tail, clause);
     }
     return clauseList;
 }
 
-template <class TreeBuilder> TreeClause JSParser::parseSwitchDefaultClause(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeClause JSParser<LexerType>::parseSwitchDefaultClause(TreeBuilder& context)
 {
     if (!match(DEFAULT))
         return 0;
+    int start = tokenStart();
     next();
     consumeOrFail(COLON);
     TreeSourceElements statements = parseSourceElements(context);
     failIfFalse(statements);
-    return context.createClause(0, statements);
+    return context.setRange(context.createClause(0, statements), start, lastTokenEnd());
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseTryStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseTryStatement(TreeBuilder& context)
 {
     ASSERT(match(TRY));
     TreeStatement tryBlock = 0;
@@ -670,7 +706,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseTryStatement(TreeBuild
     return context.createTryStatement(tryBlock, ident, catchHasEval, catchBlock, finallyBlock, firstLine, lastLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseDebuggerStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseDebuggerStatement(TreeBuilder& context)
 {
     ASSERT(match(DEBUGGER));
     int startLine = tokenLine();
@@ -682,7 +719,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseDebuggerStatement(Tree
     return context.createDebugger(startLine, endLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseBlockStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseBlockStatement(TreeBuilder& context)
 {
     ASSERT(match(OPENBRACE));
     int start = tokenLine();
@@ -698,45 +736,65 @@ template <class TreeBuilder> TreeStatement JSParser::parseBlockStatement(TreeBui
     return context.createBlockStatement(subtree, start, m_lastLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseStatement(TreeBuilder& context)
 {
     failIfStackOverflow();
+    int start = tokenStart();
+    TreeStatement result = 0;
     switch (m_token.m_type) {
     case OPENBRACE:
-        return parseBlockStatement(context);
+        result = parseBlockStatement(context);
+        break;
     case VAR:
-        return parseVarDeclaration(context);
+        result = parseVarDeclaration(context);
+        break;
     case CONSTTOKEN:
-        return parseConstDeclaration(context);
+        result = parseConstDeclaration(context);
+        break;
     case FUNCTION:
-        return parseFunctionDeclaration(context);
+        result = parseFunctionDeclaration(context);
+        break;
     case SEMICOLON:
         next();
-        return context.createEmptyStatement();
+        result = context.createEmptyStatement();
+        break;
     case IF:
-        return parseIfStatement(context);
+        result = parseIfStatement(context);
+        break;
     case DO:
-        return parseDoWhileStatement(context);
+        result = parseDoWhileStatement(context);
+        break;
     case WHILE:
-        return parseWhileStatement(context);
+        result = parseWhileStatement(context);
+        break;
     case FOR:
-        return parseForStatement(context);
+        result = parseForStatement(context);
+        break;
     case CONTINUE:
-        return parseContinueStatement(context);
+        result = parseContinueStatement(context);
+        break;
     case BREAK:
-        return parseBreakStatement(context);
+        result = parseBreakStatement(context);
+        break;
     case RETURN:
-        return parseReturnStatement(context);
+        result = parseReturnStatement(context);
+        break;
     case WITH:
-        return parseWithStatement(context);
+        result = parseWithStatement(context);
+        break;
     case SWITCH:
-        return parseSwitchStatement(context);
+        result = parseSwitchStatement(context);
+        break;
     case THROW:
-        return parseThrowStatement(context);
+        result = parseThrowStatement(context);
+        break;
     case TRY:
-        return parseTryStatement(context);
+        result = parseTryStatement(context);
+        break;
     case DEBUGGER:
-        return parseDebuggerStatement(context);
+        result = parseDebuggerStatement(context);
+        break;
     case EOFTOK:
     case CASE:
     case CLOSEBRACE:
@@ -744,41 +802,49 @@ template <class TreeBuilder> TreeStatement JSParser::parseStatement(TreeBuilder&
         // These tokens imply the end of a set of source elements
         return 0;
     case IDENT:
-        return parseExpressionOrLabelStatement(context);
+        result = parseExpressionOrLabelStatement(context);
+        break;
     default:
-        return parseExpressionStatement(context);
+        result = parseExpressionStatement(context);
+        break;
     }
+    return context.setRange(result, start, lastTokenEnd());
 }
 
-template <class TreeBuilder> TreeFormalParameterList JSParser::parseFormalParameters(TreeBuilder& context, bool& usesArguments)
+template <typename LexerType>
+template <class TreeBuilder> TreeFormalParameterList JSParser<LexerType>::parseFormalParameters(TreeBuilder& context, bool& usesArguments)
 {
     matchOrFail(IDENT);
     usesArguments = m_globalData->propertyNames->arguments == *m_token.m_data.ident;
-    TreeFormalParameterList list = context.createFormalParameterList(*m_token.m_data.ident);
+    TreeFormalParameterList list = context.setRange(context.createFormalParameterList(*m_token.m_data.ident), tokenStart(), tokenEnd());
     TreeFormalParameterList tail = list;
     next();
     while (match(COMMA)) {
         next();
         matchOrFail(IDENT);
         const Identifier* ident = m_token.m_data.ident;
+        int start = tokenStart();
+        int end = tokenEnd();
         next();
         usesArguments = usesArguments || m_globalData->propertyNames->arguments == *ident;
-        tail = context.createFormalParameterList(tail, *ident);
+        tail = context.setRange(context.createFormalParameterList(tail, *ident), start, end);
     }
     return list;
 }
 
-template <class TreeBuilder> TreeFunctionBody JSParser::parseFunctionBody(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeFunctionBody JSParser<LexerType>::parseFunctionBody(TreeBuilder& context)
 {
     if (match(CLOSEBRACE))
         return context.createFunctionBody();
-    typename TreeBuilder::FunctionBodyBuilder bodyBuilder(m_globalData, m_lexer);
+    typename TreeBuilder::FunctionBodyBuilder bodyBuilder(m_globalData);
     typename TreeBuilder::SourceElements function = parseSourceElements(bodyBuilder);
     failIfFalse(function);
     return context.createFunctionBody(function);
 }
 
-template <JSParser::FunctionRequirements requirements, class TreeBuilder> bool JSParser::parseFunctionInfo(TreeBuilder& context, const Identifier*& name, TreeFormalParameterList& parameters, TreeFunctionBody& body, int& openBracePos, int& closeBracePos, int& bodyStartLine)
+template <typename LexerType>
+template <FunctionRequirements requirements, class TreeBuilder> bool JSParser<LexerType>::parseFunctionInfo(TreeBuilder& context, const Identifier*& name, TreeFormalParameterList& parameters, TreeFunctionBody& body, int& openBracePos, int& closeBracePos, int& bodyStartLine)
 {
     if (match(IDENT)) {
         name = m_token.m_data.ident;
@@ -796,6 +862,7 @@ template <JSParser::FunctionRequirements requirements, class TreeBuilder> bool J
 
     openBracePos = m_token.m_data.intValue;
     bodyStartLine = tokenLine();
+    int bodyStart = tokenStart();
     next();
 
     body = parseFunctionBody(context);
@@ -805,11 +872,13 @@ template <JSParser::FunctionRequirements requirements, class TreeBuilder> bool J
 
     matchOrFail(CLOSEBRACE);
     closeBracePos = m_token.m_data.intValue;
+    context.setRange(body, bodyStart, tokenEnd());
     next();
     return true;
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseFunctionDeclaration(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseFunctionDeclaration(TreeBuilder& context)
 {
     ASSERT(match(FUNCTION));
     next();
@@ -824,7 +893,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseFunctionDeclaration(Tr
     return context.createFuncDeclStatement(name, body, parameters, openBracePos, closeBracePos, bodyStartLine, m_lastLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseExpressionOrLabelStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseExpressionOrLabelStatement(TreeBuilder& context)
 {
 
     /* Expression and Label statements are ambiguous at LL(1), to avoid
@@ -848,7 +918,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseExpressionOrLabelState
     return context.createLabelStatement(ident, statement, start, end);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseExpressionStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseExpressionStatement(TreeBuilder& context)
 {
     int startLine = tokenLine();
     TreeExpression expression = parseExpression(context);
@@ -857,7 +928,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseExpressionStatement(Tr
     return context.createExprStatement(expression, startLine, m_lastLine);
 }
 
-template <class TreeBuilder> TreeStatement JSParser::parseIfStatement(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeStatement JSParser<LexerType>::parseIfStatement(TreeBuilder& context)
 {
     ASSERT(match(IF));
 
@@ -879,6 +951,7 @@ template <class TreeBuilder> TreeStatement JSParser::parseIfStatement(TreeBuilde
     
     Vector<TreeExpression> exprStack;
     Vector<pair<int, int> > posStack;
+    Vector<int> offsetStack;
     Vector<TreeStatement> statementStack;
     bool trailingElse = false;
     do {
@@ -891,6 +964,7 @@ template <class TreeBuilder> TreeStatement JSParser::parseIfStatement(TreeBuilde
             break;
         }
         int innerStart = tokenLine();
+        offsetStack.append(tokenStart());
         next();
         
         consumeOrFail(OPENPAREN);
@@ -914,7 +988,8 @@ template <class TreeBuilder> TreeStatement JSParser::parseIfStatement(TreeBuilde
         statementStack.removeLast();
         pair<int, int> pos = posStack.last();
         posStack.removeLast();
-        statementStack.append(context.createIfStatement(condition, trueBlock, pos.first, pos.second));
+        statementStack.append(context.setRange(context.createIfStatement(condition, trueBlock, pos.first, pos.second), offsetStack.last(), lastTokenEnd()));
+        offsetStack.removeLast();
     }
 
     while (!exprStack.isEmpty()) {
@@ -926,15 +1001,18 @@ template <class TreeBuilder> TreeStatement JSParser::parseIfStatement(TreeBuilde
         statementStack.removeLast();
         pair<int, int> pos = posStack.last();
         posStack.removeLast();
-        statementStack.append(context.createIfStatement(condition, trueBlock, falseBlock, pos.first, pos.second));
+        statementStack.append(context.setRange(context.createIfStatement(condition, trueBlock, falseBlock, pos.first, pos.second), offsetStack.last(), lastTokenEnd()));
+        offsetStack.removeLast();
     }
     
     return context.createIfStatement(condition, trueBlock, statementStack.last(), start, end);
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseExpression(TreeBuilder& context)
 {
     failIfStackOverflow();
+    int start = tokenStart();
     TreeExpression node = parseAssignmentExpression(context);
     failIfFalse(node);
     if (!match(COMMA))
@@ -950,11 +1028,12 @@ template <class TreeBuilder> TreeExpression JSParser::parseExpression(TreeBuilde
         failIfFalse(right);
         context.appendToComma(commaNode, right);
     }
-    return commaNode;
+    return context.setRange(commaNode, start, lastTokenEnd());
 }
 
 
-template <typename TreeBuilder> TreeExpression JSParser::parseAssignmentExpression(TreeBuilder& context)
+template <typename LexerType>
+template <typename TreeBuilder> TreeExpression JSParser<LexerType>::parseAssignmentExpression(TreeBuilder& context)
 {
     failIfStackOverflow();
     int start = tokenStart();
@@ -1008,8 +1087,10 @@ end:
     return lhs;
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseConditionalExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseConditionalExpression(TreeBuilder& context)
 {
+    int start = tokenStart();
     TreeExpression cond = parseBinaryExpression(context);
     failIfFalse(cond);
     if (!match(QUESTION))
@@ -1021,7 +1102,7 @@ template <class TreeBuilder> TreeExpression JSParser::parseConditionalExpression
 
     TreeExpression rhs = parseAssignmentExpression(context);
     failIfFalse(rhs);
-    return context.createConditionalExpr(cond, lhs, rhs);
+    return context.setRange(context.createConditionalExpr(cond, lhs, rhs), start, lastTokenEnd());
 }
 
 ALWAYS_INLINE static bool isUnaryOp(JSTokenType token)
@@ -1029,14 +1110,16 @@ ALWAYS_INLINE static bool isUnaryOp(JSTokenType token)
     return token & UnaryOpTokenFlag;
 }
 
-int JSParser::isBinaryOperator(JSTokenType token)
+template <typename LexerType>
+int JSParser<LexerType>::isBinaryOperator(JSTokenType token)
 {
     if (m_allowsIn)
         return token & (BinaryOpTokenPrecedenceMask << BinaryOpTokenAllowsInPrecedenceAdditionalShift);
     return token & BinaryOpTokenPrecedenceMask;
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseBinaryExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseBinaryExpression(TreeBuilder& context)
 {
 
     int operandStackDepth = 0;
@@ -1080,21 +1163,23 @@ template <class TreeBuilder> TreeExpression JSParser::parseBinaryExpression(Tree
 }
 
 
-template <bool complete, class TreeBuilder> TreeProperty JSParser::parseProperty(TreeBuilder& context)
+template <typename LexerType>
+template <bool complete, class TreeBuilder> TreeProperty JSParser<LexerType>::parseProperty(TreeBuilder& context)
 {
     bool wasIdent = false;
+    int start = tokenStart();
     switch (m_token.m_type) {
     namedProperty:
     case IDENT:
         wasIdent = true;
     case STRING: {
         const Identifier* ident = m_token.m_data.ident;
-        next(Lexer::IgnoreReservedWords);
+        next(IgnoreReservedWords);
         if (match(COLON)) {
             next();
             TreeExpression node = parseAssignmentExpression(context);
             failIfFalse(node);
-            return context.template createProperty<complete>(ident, node, PropertyNode::Constant);
+            return context.setRange(context.template createProperty<complete>(ident, node, PropertyNode::Constant), start, lastTokenEnd());
         }
         failIfFalse(wasIdent);
         matchOrFail(IDENT);
@@ -1112,7 +1197,7 @@ template <bool complete, class TreeBuilder> TreeProperty JSParser::parseProperty
         else
             fail();
         failIfFalse(parseFunctionInfo<FunctionNeedsName>(context, accessorName, parameters, body, openBracePos, closeBracePos, bodyStartLine));
-        return context.template createGetterOrSetterProperty<complete>(type, accessorName, parameters, body, openBracePos, closeBracePos, bodyStartLine, m_lastLine);
+        return context.setRange(context.template createGetterOrSetterProperty<complete>(type, accessorName, parameters, body, openBracePos, closeBracePos, bodyStartLine, m_lastLine), start, lastTokenEnd());
     }
     case NUMBER: {
         double propertyName = m_token.m_data.doubleValue;
@@ -1120,7 +1205,7 @@ template <bool complete, class TreeBuilder> TreeProperty JSParser::parseProperty
         consumeOrFail(COLON);
         TreeExpression node = parseAssignmentExpression(context);
         failIfFalse(node);
-        return context.template createProperty<complete>(m_globalData, propertyName, node, PropertyNode::Constant);
+        return context.setRange(context.template createProperty<complete>(m_globalData, propertyName, node, PropertyNode::Constant), start, lastTokenEnd());
     }
     default:
         failIfFalse(m_token.m_type & KeywordTokenFlag);
@@ -1128,7 +1213,8 @@ template <bool complete, class TreeBuilder> TreeProperty JSParser::parseProperty
     }
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseObjectLiteral(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseObjectLiteral(TreeBuilder& context)
 {
     int startOffset = m_token.m_data.intValue;
     consumeOrFail(OPENBRACE);
@@ -1167,28 +1253,39 @@ template <class TreeBuilder> TreeExpression JSParser::parseObjectLiteral(TreeBui
     return context.createObjectLiteral(propertyList);
 }
 
+// Orders strings by width, length and then characters, which is enough for
+// a map: equal strings always have the same width.
+struct UStringLess {
+    bool operator()(const UString& a, const UString& b) const
+    {
+        if (a.is8Bit() != b.is8Bit())
+            return a.is8Bit();
+        if (a.length() != b.length())
+            return a.length() < b.length();
+        if (a.is8Bit())
+            return memcmp(a.characters8(), b.characters8(), a.length()) < 0;
+        return memcmp(a.characters16(), b.characters16(), a.length() * sizeof(UChar)) < 0;
+    }
+};
+
+// The kinds (PropertyNode::Type) seen so far for every property name of an
+// object literal with accessors.
 class ObjectValidationMap
 {
 public:
-    struct IteratorData
-    {
-        int second;
-    };
+    typedef std::map<UString, unsigned, UStringLess>::iterator iterator;
 
-    class iterator
+    std::pair<iterator, bool> add(const UString& name, unsigned type)
     {
-    public:
-        iterator() {}
-        struct IteratorData* operator->() const { return 0; }
-    };
-
-    //typedef IteratorData* iterator;
-    std::pair<ObjectValidationMap::iterator, bool> add(const UString& name, unsigned type) {
-        return std::make_pair<ObjectValidationMap::iterator, bool>(iterator(), false);
+        return m_map.insert(std::make_pair(name, type));
     }
+
+private:
+    std::map<UString, unsigned, UStringLess> m_map;
 };
 
-template <class TreeBuilder> TreeExpression JSParser::parseStrictObjectLiteral(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseStrictObjectLiteral(TreeBuilder& context)
 {
     consumeOrFail(OPENBRACE);
     
@@ -1223,6 +1320,7 @@ template <class TreeBuilder> TreeExpression JSParser::parseStrictObjectLiteral(T
                     failIfTrue(context.getType(property) & propertyEntryIter.first->second);
                     failIfTrue((context.getType(property) | propertyEntryIter.first->second) & PropertyNode::Constant);
                 }
+                propertyEntryIter.first->second |= context.getType(property);
             }
         }
         tail = context.createPropertyList(property, tail);
@@ -1233,7 +1331,8 @@ template <class TreeBuilder> TreeExpression JSParser::parseStrictObjectLiteral(T
     return context.createObjectLiteral(propertyList);
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseArrayLiteral(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseArrayLiteral(TreeBuilder& context)
 {
     consumeOrFail(OPENBRACKET);
 
@@ -1275,7 +1374,8 @@ template <class TreeBuilder> TreeExpression JSParser::parseArrayLiteral(TreeBuil
     return context.createArray(elementList);
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parsePrimaryExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parsePrimaryExpression(TreeBuilder& context)
 {
     switch (m_token.m_type) {
     case OPENBRACE:
@@ -1342,7 +1442,8 @@ template <class TreeBuilder> TreeExpression JSParser::parsePrimaryExpression(Tre
     }
 }
 
-template <class TreeBuilder> TreeArguments JSParser::parseArguments(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeArguments JSParser<LexerType>::parseArguments(TreeBuilder& context)
 {
     consumeOrFail(OPENPAREN);
     if (match(CLOSEPAREN)) {
@@ -1364,7 +1465,8 @@ template <class TreeBuilder> TreeArguments JSParser::parseArguments(TreeBuilder&
     return context.createArguments(argList);
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseMemberExpression(TreeBuilder& context)
 {
     TreeExpression base = 0;
     int start = tokenStart();
@@ -1374,6 +1476,9 @@ template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(Tree
         next();
         newCount++;
     }
+    // Where the expression built so far starts, which is before any 'new'
+    // once it has been applied.
+    int chainStart = tokenStart();
     if (match(FUNCTION)) {
         const Identifier* name = &m_globalData->propertyNames->nullIdentifier;
         TreeFormalParameterList parameters = 0;
@@ -1388,6 +1493,7 @@ template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(Tree
         base = parsePrimaryExpression(context);
 
     failIfFalse(base);
+    context.setRange(base, chainStart, lastTokenEnd());
     while (true) {
         switch (m_token.m_type) {
         case OPENBRACKET: {
@@ -1400,6 +1506,7 @@ template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(Tree
             base = context.createBracketAccess(base, property, initialAssignments != m_assignmentCount, expressionStart, expressionEnd, tokenEnd());
             if (!consume(CLOSEBRACKET))
                 fail();
+            context.setRange(base, chainStart, lastTokenEnd());
             m_nonLHSCount = nonLHSCount;
             break;
         }
@@ -1413,22 +1520,26 @@ template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(Tree
                     base = context.createNewExpr(base, arguments, start, exprEnd, lastTokenEnd());
                 } else
                     base = context.createNewExpr(base, start, lastTokenEnd());               
+                chainStart = start;
+                context.setRange(base, chainStart, lastTokenEnd());
             } else {
                 int nonLHSCount = m_nonLHSCount;
                 int expressionEnd = lastTokenEnd();
                 TreeArguments arguments = parseArguments(context);
                 failIfFalse(arguments);
                 base = context.makeFunctionCallNode(base, arguments, expressionStart, expressionEnd, lastTokenEnd());
+                context.setRange(base, chainStart, lastTokenEnd());
                 m_nonLHSCount = nonLHSCount;
             }
             break;
         }
         case DOT: {
             int expressionEnd = lastTokenEnd();
-            next(Lexer::IgnoreReservedWords);
+            next(IgnoreReservedWords);
             matchOrFail(IDENT);
             base = context.createDotAccess(base, *m_token.m_data.ident, expressionStart, expressionEnd, tokenEnd());
             next();
+            context.setRange(base, chainStart, lastTokenEnd());
             break;
         }
         default:
@@ -1437,11 +1548,12 @@ template <class TreeBuilder> TreeExpression JSParser::parseMemberExpression(Tree
     }
 endMemberExpression:
     while (newCount--)
-        base = context.createNewExpr(base, start, lastTokenEnd());
+        base = context.setRange(context.createNewExpr(base, start, lastTokenEnd()), start, lastTokenEnd());
     return base;
 }
 
-template <class TreeBuilder> TreeExpression JSParser::parseUnaryExpression(TreeBuilder& context)
+template <typename LexerType>
+template <class TreeBuilder> TreeExpression JSParser<LexerType>::parseUnaryExpression(TreeBuilder& context)
 {
     AllowInOverride allowInOverride(this);
     int tokenStackDepth = 0;
@@ -1456,13 +1568,13 @@ template <class TreeBuilder> TreeExpression JSParser::parseUnaryExpression(TreeB
     switch (m_token.m_type) {
     case PLUSPLUS:
         m_nonLHSCount++;
-        expr = context.makePostfixNode(expr, OpPlusPlus, subExprStart, lastTokenEnd(), tokenEnd());
+        expr = context.setRange(context.makePostfixNode(expr, OpPlusPlus, subExprStart, lastTokenEnd(), tokenEnd()), subExprStart, tokenEnd());
         m_assignmentCount++;
         next();
         break;
     case MINUSMINUS:
         m_nonLHSCount++;
-        expr = context.makePostfixNode(expr, OpMinusMinus, subExprStart, lastTokenEnd(), tokenEnd());
+        expr = context.setRange(context.makePostfixNode(expr, OpMinusMinus, subExprStart, lastTokenEnd(), tokenEnd()), subExprStart, tokenEnd());
         m_assignmentCount++;
         next();
         break;
@@ -1509,10 +1621,11 @@ template <class TreeBuilder> TreeExpression JSParser::parseUnaryExpression(TreeB
             expr = context.makeDeleteNode(expr, context.unaryTokenStackLastStart(tokenStackDepth), end, end);
             break;
         default:
-            // If we get here something has gone horribly horribly wrong
-            CRASH();
+            ASSERT_NOT_REACHED();
+            fail();
         }
         subExprStart = context.unaryTokenStackLastStart(tokenStackDepth);
+        context.setRange(expr, subExprStart, end);
         context.unaryTokenStackRemoveLast(tokenStackDepth);
     }
     return expr;
@@ -144,7 +144,7 @@ union JSTokenData {
 };
 
 struct JSTokenInfo {
-    JSTokenInfo() : line(0) {}
+    JSTokenInfo() : line(0), startOffset(0), endOffset(0) {}
     int line;
     int startOffset;
     int endOffset;
@@ -29,6 +29,7 @@
 #include "Nodes.h"
 #include "dtoa.h"
 #include <ctype.h>
+#include <float.h>
 #include <limits.h>
 #include <string.h>
 #include <wtf/Assertions.h>
@@ -38,6 +39,8 @@ using namespace Unicode;
 
 #include "JSParser.h"
 #include "Lookup.h"
+#include "Lexer.lut.h"
+#include "PowersOfFive.h"
 
 namespace JSC {
 
@@ -217,30 +220,60 @@ static const unsigned short typesOfASCIICharacters[128] = {
 /* 127 - Delete             */ CharacterInvalid,
 };
 
-Lexer::Lexer(JSGlobalData* globalData)
+template <typename CharType>
+const HashEntry* HashTable::entry(const CharType* characters, int length)
+{
+    if (length < minimumKeywordLength || length > maximumKeywordLength)
+        return 0;
+
+    // The table is a perfect hash, so the slot holds the only candidate.
+    const HashEntry* entry = &keywordTable[keywordHash(characters, length)];
+    if (entry->length != length)
+        return 0;
+    for (int i = 0; i < length; ++i) {
+        if (characters[i] != static_cast<unsigned char>(entry->key[i]))
+            return 0;
+    }
+    return entry;
+}
+
+const HashEntry* HashTable::entry(JSGlobalData*, const Identifier& identifier) const
+{
+    if (identifier.is8Bit())
+        return entry(identifier.characters8(), identifier.length());
+    return entry(identifier.characters16(), identifier.length());
+}
+
+template <typename T>
+Lexer<T>::Lexer(JSGlobalData* globalData)
     : m_isReparsing(false)
+    , m_scanner(CharacterScanner<T>::get())
     , m_globalData(globalData)
     , m_keywordTable(JSC::mainTable)
 {
 }
 
-Lexer::~Lexer()
+template <typename T>
+Lexer<T>::~Lexer()
 {
     m_keywordTable.deleteTable();
 }
 
-ALWAYS_INLINE const UChar* Lexer::currentCharacter() const
+template <typename T>
+ALWAYS_INLINE const T* Lexer<T>::currentCharacter() const
 {
     ASSERT(m_code <= m_codeEnd);
     return m_code;
 }
 
-ALWAYS_INLINE int Lexer::currentOffset() const
+template <typename T>
+ALWAYS_INLINE int Lexer<T>::currentOffset() const
 {
     return currentCharacter() - m_codeStart;
 }
 
-void Lexer::setCode(const SourceCode& source, ParserArena& arena)
+template <typename T>
+void Lexer<T>::setCode(const SourceCode& source, ParserArena& arena)
 {
     m_arena = &arena.identifierArena();
 
@@ -248,7 +281,7 @@ void Lexer::setCode(const SourceCode& source, ParserArena& arena)
     m_delimited = false;
     m_lastToken = -1;
 
-    const UChar* data = source.provider()->data();
+    const T* data = source.provider()->data<T>();
 
     m_source = &source;
     m_codeStart = data;
@@ -257,8 +290,8 @@ void Lexer::setCode(const SourceCode& source, ParserArena& arena)
     m_error = false;
     m_atLineStart = true;
 
-    m_buffer8.reserveInitialCapacity(initialReadBufferCapacity);
-    m_buffer16.reserveInitialCapacity((m_codeEnd - m_code) / 2);
+    m_buffer8.reserveCapacity(initialReadBufferCapacity);
+    m_buffer16.reserveCapacity((m_codeEnd - m_code) / 2);
 
     if (LIKELY(m_code < m_codeEnd))
         m_current = *m_code;
@@ -267,7 +300,8 @@ void Lexer::setCode(const SourceCode& source, ParserArena& arena)
     ASSERT(currentOffset() == source.startOffset());
 }
 
-ALWAYS_INLINE void Lexer::shift()
+template <typename T>
+ALWAYS_INLINE void Lexer<T>::shift()
 {
     // Faster than an if-else sequence
     ASSERT(m_current != -1);
@@ -277,15 +311,26 @@ ALWAYS_INLINE void Lexer::shift()
         m_current = *m_code;
 }
 
-ALWAYS_INLINE int Lexer::peek(int offset)
+// Moves to a position found by one of the m_scanner functions.
+template <typename T>
+ALWAYS_INLINE void Lexer<T>::skipTo(const T* position)
+{
+    ASSERT(position >= m_code && position <= m_codeEnd);
+    m_code = position;
+    m_current = LIKELY(m_code < m_codeEnd) ? *m_code : -1;
+}
+
+template <typename T>
+ALWAYS_INLINE int Lexer<T>::peek(int offset)
 {
     // Only use if necessary
     ASSERT(offset > 0 && offset < 5);
-    const UChar* code = m_code + offset;
+    const T* code = m_code + offset;
     return (code < m_codeEnd) ? *code : -1;
 }
 
-int Lexer::getUnicodeCharacter()
+template <typename T>
+int Lexer<T>::getUnicodeCharacter()
 {
     int char1 = peek(1);
     int char2 = peek(2);
@@ -302,7 +347,8 @@ int Lexer::getUnicodeCharacter()
     return result;
 }
 
-void Lexer::shiftLineTerminator()
+template <typename T>
+void Lexer<T>::shiftLineTerminator()
 {
     ASSERT(isLineTerminator(m_current));
 
@@ -316,12 +362,15 @@ void Lexer::shiftLineTerminator()
     ++m_lineNumber;
 }
 
-ALWAYS_INLINE const Identifier* Lexer::makeIdentifier(const UChar* characters, size_t length)
+template <typename T>
+template <typename CharType>
+ALWAYS_INLINE const Identifier* Lexer<T>::makeIdentifier(const CharType* characters, size_t length)
 {
     return &m_arena->makeIdentifier(m_globalData, characters, length);
 }
 
-ALWAYS_INLINE bool Lexer::lastTokenWasRestrKeyword() const
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::lastTokenWasRestrKeyword() const
 {
     return m_lastToken == CONTINUE || m_lastToken == BREAK || m_lastToken == RETURN || m_lastToken == THROW;
 }
@@ -376,33 +425,37 @@ static inline int singleEscape(int c)
     }
 }
 
-inline void Lexer::record8(int c)
+template <typename T>
+inline void Lexer<T>::record8(int c)
 {
     ASSERT(c >= 0);
     ASSERT(c <= 0xFF);
     m_buffer8.append(static_cast<char>(c));
 }
 
-inline void Lexer::record16(UChar c)
+template <typename T>
+inline void Lexer<T>::record16(UChar c)
 {
     m_buffer16.append(c);
 }
 
-inline void Lexer::record16(int c)
+template <typename T>
+inline void Lexer<T>::record16(int c)
 {
     ASSERT(c >= 0);
     ASSERT(c <= USHRT_MAX);
     record16(UChar(static_cast<unsigned short>(c)));
 }
 
-ALWAYS_INLINE JSTokenType Lexer::parseIdentifier(JSTokenData* lvalp, LexType lexType)
+template <typename T>
+ALWAYS_INLINE JSTokenType Lexer<T>::parseIdentifier(JSTokenData* lvalp, LexType lexType)
 {
     bool bufferRequired = false;
-    const UChar* identifierStart = currentCharacter();
-    int identifierLength;
+    const T* identifierStart = currentCharacter();
 
     while (true) {
-        if (LIKELY(isIdentPart(m_current))) {
+        skipTo(m_scanner.skipIdentifierPart(m_code, m_codeEnd));
+        if (UNLIKELY(isIdentPart(m_current))) {
             shift();
             continue;
         }
@@ -426,38 +479,47 @@ ALWAYS_INLINE JSTokenType Lexer::parseIdentifier(JSTokenData* lvalp, LexType lex
         identifierStart = currentCharacter();
     }
 
-    if (!bufferRequired)
-        identifierLength = currentCharacter() - identifierStart;
+    // Without escapes the name is interned straight from the source, in the
+    // source's own character width.
+    IdentifierArena::Entry* entry;
+    if (LIKELY(!bufferRequired))
+        entry = &m_arena->intern(m_globalData, identifierStart, currentCharacter() - identifierStart);
     else {
         if (identifierStart != currentCharacter())
             m_buffer16.append(identifierStart, currentCharacter() - identifierStart);
-        identifierStart = m_buffer16.data();
-        identifierLength = m_buffer16.size();
+        entry = &m_arena->intern(m_globalData, m_buffer16.data(), m_buffer16.size());
     }
 
-    const Identifier* ident = makeIdentifier(identifierStart, identifierLength);
-    lvalp->ident = ident;
+    lvalp->ident = &entry->identifier;
     m_delimited = false;
 
     if (LIKELY(!bufferRequired && lexType == IdentifyReservedWords)) {
         // Keywords must not be recognized if there was an \uXXXX in the identifier.
-        const HashEntry* entry = m_keywordTable.entry(m_globalData, *ident);
-        return entry ? static_cast<JSTokenType>(entry->lexerValue()) : IDENT;
+        // The keyword lookup is done once per distinct name and kept in the arena.
+        if (UNLIKELY(entry->token < 0)) {
+            const HashEntry* keyword = m_keywordTable.entry(m_globalData, entry->identifier);
+            entry->token = keyword ? keyword->lexerValue() : IDENT;
+        }
+        return static_cast<JSTokenType>(entry->token);
     }
 
     m_buffer16.resize(0);
     return IDENT;
 }
 
-ALWAYS_INLINE bool Lexer::parseString(JSTokenData* lvalp)
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::parseString(JSTokenData* lvalp)
 {
     int stringQuoteCharacter = m_current;
     shift();
 
-    const UChar* stringStart = currentCharacter();
+    const T* stringStart = currentCharacter();
 
-    while (m_current != stringQuoteCharacter) {
-        if (UNLIKELY(m_current == '\\')) {
+    while (true) {
+        skipTo(m_scanner.findStringSpecial(m_code, m_codeEnd, static_cast<T>(stringQuoteCharacter)));
+        if (m_current == stringQuoteCharacter)
+            break;
+        if (LIKELY(m_current == '\\')) {
             if (stringStart != currentCharacter())
                 m_buffer16.append(stringStart, currentCharacter() - stringStart);
             shift();
@@ -512,18 +574,15 @@ ALWAYS_INLINE bool Lexer::parseString(JSTokenData* lvalp)
             stringStart = currentCharacter();
             continue;
         }
-        // Fast check for characters that require special handling.
-        // Catches -1, \n, \r, 0x2028, and 0x2029 as efficiently
-        // as possible, and lets through all common ASCII characters.
-        if (UNLIKELY(((static_cast<unsigned>(m_current) - 0xE) & 0x2000))) {
-            // New-line or end of input is not allowed
-            if (UNLIKELY(isLineTerminator(m_current)) || UNLIKELY(m_current == -1))
-                return false;
-            // Anything else is just a normal character
-        }
-        shift();
+        // New-line or end of input is not allowed
+        return false;
     }
 
+    // A string without escapes is made straight from the source.
+    if (m_buffer16.isEmpty()) {
+        lvalp->ident = makeIdentifier(stringStart, currentCharacter() - stringStart);
+        return true;
+    }
     if (currentCharacter() != stringStart)
         m_buffer16.append(stringStart, currentCharacter() - stringStart);
     lvalp->ident = makeIdentifier(m_buffer16.data(), m_buffer16.size());
@@ -531,7 +590,8 @@ ALWAYS_INLINE bool Lexer::parseString(JSTokenData* lvalp)
     return true;
 }
 
-ALWAYS_INLINE void Lexer::parseHex(double& returnValue)
+template <typename T>
+ALWAYS_INLINE void Lexer<T>::parseHex(double& returnValue)
 {
     // Optimization: most hexadecimal values fit into 4 bytes.
     uint32_t hexValue = 0;
@@ -570,7 +630,8 @@ ALWAYS_INLINE void Lexer::parseHex(double& returnValue)
     returnValue = parseIntOverflow(m_buffer8.data(), m_buffer8.size(), 16);
 }
 
-ALWAYS_INLINE bool Lexer::parseOctal(double& returnValue)
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::parseOctal(double& returnValue)
 {
     // Optimization: most octal values fit into 4 bytes.
     uint32_t octalValue = 0;
@@ -606,7 +667,8 @@ ALWAYS_INLINE bool Lexer::parseOctal(double& returnValue)
     return true;
 }
 
-ALWAYS_INLINE bool Lexer::parseDecimal(double& returnValue)
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::parseDecimal(double& returnValue)
 {
     // Optimization: most decimal values fit into 4 bytes.
     uint32_t decimalValue = 0;
@@ -643,7 +705,184 @@ ALWAYS_INLINE bool Lexer::parseDecimal(double& returnValue)
     return false;
 }
 
-ALWAYS_INLINE void Lexer::parseNumberAfterDecimalPoint()
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int maximumExactPowerOfTen = 22;
+static const uint64_t maximumExactInteger = static_cast<uint64_t>(1) << 53;
+
+// Returns the low 64 bits of a * b and stores the high 64 bits in high.
+static inline uint64_t multiplyFull(uint64_t a, uint64_t b, uint64_t& high)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#else
+    uint64_t aLow = a & 0xFFFFFFFF;
+    uint64_t aHigh = a >> 32;
+    uint64_t bLow = b & 0xFFFFFFFF;
+    uint64_t bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow;
+    uint64_t lowHigh = aLow * bHigh;
+    uint64_t highLow = aHigh * bLow;
+    uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+    high = aHigh * bHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    return (middle << 32) | (lowLow & 0xFFFFFFFF);
+#endif
+}
+
+static inline int countLeadingZeros(uint64_t value)
+{
+    ASSERT(value);
+#if COMPILER(GCC)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    for (; !(value >> 63); value <<= 1)
+        ++count;
+    return count;
+#endif
+}
+
+// Eisel and Lemire's algorithm: the top bits of significand * 5^exponent,
+// taken from a 128-bit approximation of the power, give the correctly
+// rounded double unless the product is too close to a rounding boundary to
+// tell. Subnormal and infinite results are left to strtod as well.
+static bool eiselLemire(uint64_t significand, int exponent, double& result)
+{
+    if (exponent < smallestPowerOfFive || exponent > largestPowerOfFive)
+        return false;
+
+    int leadingZeros = countLeadingZeros(significand);
+    significand <<= leadingZeros;
+
+    // 53 bits of mantissa, one to round and one to tell where the top bit
+    // is leave 9 bits that are all ones when the first product is short.
+    const uint64_t* power = powersOfFive + 2 * (exponent - smallestPowerOfFive);
+    uint64_t high;
+    uint64_t low = multiplyFull(significand, power[0], high);
+    if ((high & 0x1FF) == 0x1FF) {
+        uint64_t secondHigh;
+        multiplyFull(significand, power[1], secondHigh);
+        low += secondHigh;
+        if (secondHigh > low)
+            ++high;
+    }
+    // Outside this range the 128-bit power is not exact and the lost bits
+    // could carry into the result.
+    if (low == ~static_cast<uint64_t>(0) && (exponent < -27 || exponent > 55))
+        return false;
+
+    int upperBit = static_cast<int>(high >> 63);
+    int shift = upperBit + 9;
+    uint64_t mantissa = high >> shift;
+    // floor(log2(5^exponent)) + exponent is (217706 * exponent) >> 16.
+    int binaryExponent = ((217706 * exponent) >> 16) + 63 + upperBit - leadingZeros + 1023;
+    if (binaryExponent <= 0)
+        return false;
+
+    // Exactly halfway between two doubles: round to even.
+    if (low <= 1 && exponent >= -4 && exponent <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+        mantissa &= ~static_cast<uint64_t>(1);
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (static_cast<uint64_t>(2) << 52)) {
+        mantissa = static_cast<uint64_t>(1) << 52;
+        ++binaryExponent;
+    }
+    if (binaryExponent >= 0x7FF)
+        return false;
+
+    uint64_t bits = (mantissa & ~(static_cast<uint64_t>(1) << 52)) | (static_cast<uint64_t>(binaryExponent) << 52);
+    memcpy(&result, &bits, sizeof(result));
+    return true;
+}
+
+// Converts the digits collected in m_buffer8 ([0-9]*(.[0-9]*)?(e[+-]?[0-9]+)?)
+// without strtod. A significand of at most 53 bits scaled by an exact power
+// of ten needs one correctly rounded multiplication or division (Clinger's
+// fast path); other significands of up to 19 digits go through eiselLemire.
+// Returns false when strtod has to decide.
+static bool parseDecimalLiteral(const char* characters, const char* end, double& result)
+{
+    uint64_t significand = 0;
+    int exponent = 0;
+    int significantDigits = 0;
+
+    for (; characters < end && isASCIIDigit(*characters); ++characters) {
+        if (significantDigits == 19)
+            return false;
+        significand = significand * 10 + (*characters - '0');
+        if (significand)
+            ++significantDigits;
+    }
+    if (characters < end && *characters == '.') {
+        for (++characters; characters < end && isASCIIDigit(*characters); ++characters) {
+            if (significantDigits == 19)
+                return false;
+            significand = significand * 10 + (*characters - '0');
+            if (significand)
+                ++significantDigits;
+            --exponent;
+        }
+    }
+    if (characters < end) {
+        ASSERT(*characters == 'e');
+        bool negative = false;
+        if (*++characters == '+')
+            ++characters;
+        else if (*characters == '-') {
+            negative = true;
+            ++characters;
+        }
+        int exponentPart = 0;
+        for (; characters < end; ++characters) {
+            if (exponentPart > 1000)
+                return false;
+            exponentPart = exponentPart * 10 + (*characters - '0');
+        }
+        exponent += negative ? -exponentPart : exponentPart;
+    }
+
+    if (!significand) {
+        result = 0;
+        return true;
+    }
+
+    if (significand <= maximumExactInteger) {
+        // Move trailing powers of ten into the significand while it stays
+        // exact, which also covers integers such as 1e25.
+        int clingerExponent = exponent;
+        uint64_t clingerSignificand = significand;
+        while (clingerExponent > maximumExactPowerOfTen && clingerSignificand * 10 <= maximumExactInteger) {
+            clingerSignificand *= 10;
+            --clingerExponent;
+        }
+        double value = static_cast<double>(clingerSignificand);
+        if (!clingerExponent) {
+            result = value;
+            return true;
+        }
+        // Extended precision intermediates (x87) would round twice.
+#if (defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0) || (defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ == 0)
+        if (clingerExponent > 0 && clingerExponent <= maximumExactPowerOfTen) {
+            result = value * exactPowersOfTen[clingerExponent];
+            return true;
+        }
+        if (clingerExponent < 0 && clingerExponent >= -maximumExactPowerOfTen) {
+            result = value / exactPowersOfTen[-clingerExponent];
+            return true;
+        }
+#endif
+    }
+
+    return eiselLemire(significand, exponent, result);
+}
+
+template <typename T>
+ALWAYS_INLINE void Lexer<T>::parseNumberAfterDecimalPoint()
 {
     record8('.');
     while (isASCIIDigit(m_current)) {
@@ -652,7 +891,8 @@ ALWAYS_INLINE void Lexer::parseNumberAfterDecimalPoint()
     }
 }
 
-ALWAYS_INLINE bool Lexer::parseNumberAfterExponentIndicator()
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::parseNumberAfterExponentIndicator()
 {
     record8('e');
     shift();
@@ -671,9 +911,11 @@ ALWAYS_INLINE bool Lexer::parseNumberAfterExponentIndicator()
     return true;
 }
 
-ALWAYS_INLINE bool Lexer::parseMultilineComment()
+template <typename T>
+ALWAYS_INLINE bool Lexer<T>::parseMultilineComment()
 {
     while (true) {
+        skipTo(m_scanner.findCommentSpecial(m_code, m_codeEnd));
         while (UNLIKELY(m_current == '*')) {
             shift();
             if (m_current == '/') {
@@ -692,7 +934,8 @@ ALWAYS_INLINE bool Lexer::parseMultilineComment()
     }
 }
 
-JSTokenType Lexer::lex(JSTokenData* lvalp, JSTokenInfo* llocp, LexType lexType)
+template <typename T>
+JSTokenType Lexer<T>::lex(JSTokenData* lvalp, JSTokenInfo* llocp, LexType lexType)
 {
     ASSERT(!m_error);
     ASSERT(m_buffer8.isEmpty());
@@ -702,13 +945,19 @@ JSTokenType Lexer::lex(JSTokenData* lvalp, JSTokenInfo* llocp, LexType lexType)
     m_terminator = false;
 
 start:
-    while (isWhiteSpace(m_current))
+    while (isWhiteSpace(m_current)) {
         shift();
+        // Indentation comes in runs.
+        if (m_current == ' ' || m_current == '\t')
+            skipTo(m_scanner.skipSpaces(m_code, m_codeEnd));
+    }
 
     int startOffset = currentOffset();
 
-    if (UNLIKELY(m_current == -1))
-        return EOFTOK;
+    if (UNLIKELY(m_current == -1)) {
+        token = EOFTOK;
+        goto returnToken;
+    }
 
     m_delimited = false;
 
@@ -988,9 +1237,11 @@ inNumberAfterDecimalPoint:
                 if ((m_current | 0x20) == 'e')
                     if (!parseNumberAfterExponentIndicator())
                         goto returnError;
-                // Null-terminate string for strtod.
-                m_buffer8.append('\0');
-                lvalp->doubleValue = WTF::strtod(m_buffer8.data(), 0);
+                if (!parseDecimalLiteral(m_buffer8.data(), m_buffer8.data() + m_buffer8.size(), lvalp->doubleValue)) {
+                    // Null-terminate string for strtod.
+                    m_buffer8.append('\0');
+                    lvalp->doubleValue = WTF::strtod(m_buffer8.data(), 0);
+                }
             }
             token = NUMBER;
         }
@@ -1036,10 +1287,10 @@ inNumberAfterDecimalPoint:
     goto returnToken;
 
 inSingleLineComment:
-    while (!isLineTerminator(m_current)) {
-        if (UNLIKELY(m_current == -1))
-            return EOFTOK;
-        shift();
+    skipTo(m_scanner.findLineTerminator(m_code, m_codeEnd));
+    if (UNLIKELY(m_current == -1)) {
+        token = EOFTOK;
+        goto returnToken;
     }
     shiftLineTerminator();
     m_atLineStart = true;
@@ -1063,7 +1314,8 @@ returnError:
     return ERRORTOK;
 }
 
-bool Lexer::scanRegExp(const Identifier*& pattern, const Identifier*& flags, UChar patternPrefix)
+template <typename T>
+bool Lexer<T>::scanRegExp(const Identifier*& pattern, const Identifier*& flags, UChar patternPrefix)
 {
     ASSERT(m_buffer16.isEmpty());
 
@@ -1124,7 +1376,8 @@ bool Lexer::scanRegExp(const Identifier*& pattern, const Identifier*& flags, UCh
     return true;
 }
 
-bool Lexer::skipRegExp()
+template <typename T>
+bool Lexer<T>::skipRegExp()
 {
     bool lastWasEscape = false;
     bool inBrackets = false;
@@ -1164,24 +1417,36 @@ bool Lexer::skipRegExp()
     return true;
 }
 
-void Lexer::clear()
+template <typename T>
+void Lexer<T>::clear()
 {
     m_arena = 0;
 
-    Vector<char> newBuffer8;
-    m_buffer8.swap(newBuffer8);
+    // Keep the buffers for the next source unless a large one inflated them.
+    m_buffer8.shrink(0);
+    if (m_buffer8.capacity() > maximumRetainedBufferCapacity) {
+        Vector<char> newBuffer8;
+        m_buffer8.swap(newBuffer8);
+    }
 
-    Vector<UChar> newBuffer16;
-    m_buffer16.swap(newBuffer16);
+    m_buffer16.shrink(0);
+    if (m_buffer16.capacity() > maximumRetainedBufferCapacity) {
+        Vector<UChar> newBuffer16;
+        m_buffer16.swap(newBuffer16);
+    }
 
     m_isReparsing = false;
 }
 
-SourceCode Lexer::sourceCode(int openBrace, int closeBrace, int firstLine)
+template <typename T>
+SourceCode Lexer<T>::sourceCode(int openBrace, int closeBrace, int firstLine)
 {
-    ASSERT(m_source->provider()->data()[openBrace] == '{');
-    ASSERT(m_source->provider()->data()[closeBrace] == '}');
+    ASSERT(m_source->provider()->data<T>()[openBrace] == '{');
+    ASSERT(m_source->provider()->data<T>()[closeBrace] == '}');
     return SourceCode(m_source->provider(), openBrace, closeBrace + 1, firstLine);
 }
 
+template class Lexer<LChar>;
+template class Lexer<UChar>;
+
 } // namespace JSC
@@ -23,6 +23,7 @@
 #ifndef Lexer_h
 #define Lexer_h
 
+#include "CharacterScanner.h"
 #include "JSParser.h"
 #include "Lookup.h"
 #include "ParserArena.h"
@@ -35,6 +36,12 @@ namespace JSC {
 
     class RegExp;
 
+    enum LexType { IdentifyReservedWords, IgnoreReservedWords };
+
+    // The lexer reads Latin-1 (LChar) or UTF-16 (UChar) source directly;
+    // JSGlobalData owns one of each and the parser picks the one matching
+    // SourceProvider::is8Bit().
+    template <typename T>
     class Lexer : public Noncopyable {
     public:
         // Character manipulation functions.
@@ -48,7 +55,6 @@ namespace JSC {
         void setIsReparsing() { m_isReparsing = true; }
 
         // Functions for the parser itself.
-        enum LexType { IdentifyReservedWords, IgnoreReservedWords };
         JSTokenType lex(JSTokenData* lvalp, JSTokenInfo* llocp, LexType);
         int lineNumber() const { return m_lineNumber; }
         void setLastLineNumber(int lastLineNumber) { m_lastLineNumber = lastLineNumber; }
@@ -78,17 +84,17 @@ namespace JSC {
         void record16(int);
         void record16(UChar);
 
-        void copyCodeWithoutBOMs();
-
         ALWAYS_INLINE void shift();
+        ALWAYS_INLINE void skipTo(const T*);
         ALWAYS_INLINE int peek(int offset);
         int getUnicodeCharacter();
         void shiftLineTerminator();
 
-        ALWAYS_INLINE const UChar* currentCharacter() const;
+        ALWAYS_INLINE const T* currentCharacter() const;
         ALWAYS_INLINE int currentOffset() const;
 
-        ALWAYS_INLINE const Identifier* makeIdentifier(const UChar* characters, size_t length);
+        template <typename CharType>
+        ALWAYS_INLINE const Identifier* makeIdentifier(const CharType* characters, size_t length);
 
         ALWAYS_INLINE bool lastTokenWasRestrKeyword() const;
 
@@ -102,6 +108,7 @@ namespace JSC {
         ALWAYS_INLINE bool parseMultilineComment();
 
         static const size_t initialReadBufferCapacity = 32;
+        static const size_t maximumRetainedBufferCapacity = 64 * 1024;
 
         int m_lineNumber;
         int m_lastLineNumber;
@@ -113,9 +120,9 @@ namespace JSC {
         int m_lastToken;
 
         const SourceCode* m_source;
-        const UChar* m_code;
-        const UChar* m_codeStart;
-        const UChar* m_codeEnd;
+        const T* m_code;
+        const T* m_codeStart;
+        const T* m_codeEnd;
         bool m_isReparsing;
         bool m_atLineStart;
         bool m_error;
@@ -124,28 +131,33 @@ namespace JSC {
         int m_current;
 
         IdentifierArena* m_arena;
+        const CharacterScanner<T>& m_scanner;
 
         JSGlobalData* m_globalData;
 
         const HashTable m_keywordTable;
     };
 
-    inline bool Lexer::isWhiteSpace(int ch)
+    template <typename T>
+    inline bool Lexer<T>::isWhiteSpace(int ch)
     {
         return isASCII(ch) ? (ch == ' ' || ch == '\t' || ch == 0xB || ch == 0xC) : (WTF::Unicode::isSeparatorSpace(ch) || ch == 0xFEFF);
     }
 
-    inline bool Lexer::isLineTerminator(int ch)
+    template <typename T>
+    inline bool Lexer<T>::isLineTerminator(int ch)
     {
         return ch == '\r' || ch == '\n' || (ch & ~1) == 0x2028;
     }
 
-    inline unsigned char Lexer::convertHex(int c1, int c2)
+    template <typename T>
+    inline unsigned char Lexer<T>::convertHex(int c1, int c2)
     {
         return (toASCIIHexValue(c1) << 4) | toASCIIHexValue(c2);
     }
 
-    inline UChar Lexer::convertUnicode(int c1, int c2, int c3, int c4)
+    template <typename T>
+    inline UChar Lexer<T>::convertUnicode(int c1, int c2, int c3, int c4)
     {
         return (convertHex(c1, c2) << 8) | convertHex(c3, c4);
     }
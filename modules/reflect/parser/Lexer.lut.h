@@ -0,0 +1,145 @@
+// Automatically generated by create_keyword_table.js. DO NOT EDIT.
+
+namespace JSC {
+
+static const int minimumKeywordLength = 2;
+static const int maximumKeywordLength = 10;
+
+template <typename CharType>
+static inline unsigned keywordHash(const CharType* characters, int length)
+{
+    return (characters[0] * 1u + characters[1] * 1u + characters[length - 1] * 30u + length) & 127;
+}
+
+static const HashEntry keywordTable[128] = {
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "finally", 7, FINALLY },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "null", 4, NULLTOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "with", 4, WITH },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "try", 3, TRY },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "enum", 4, RESERVED },
+    { "case", 4, CASE },
+    { 0, 0, IDENT },
+    { "switch", 6, SWITCH },
+    { "void", 4, VOIDTOKEN },
+    { "false", 5, FALSETOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "delete", 6, DELETETOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "else", 4, ELSE },
+    { 0, 0, IDENT },
+    { "debugger", 8, DEBUGGER },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "continue", 8, CONTINUE },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "for", 3, FOR },
+    { 0, 0, IDENT },
+    { "var", 3, VAR },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "while", 5, WHILE },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "in", 2, INTOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "true", 4, TRUETOKEN },
+    { "return", 6, RETURN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "if", 2, IF },
+    { 0, 0, IDENT },
+    { "function", 8, FUNCTION },
+    { "new", 3, NEW },
+    { "super", 5, RESERVED },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "class", 5, RESERVED },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "throw", 5, THROW },
+    { 0, 0, IDENT },
+    { "instanceof", 10, INSTANCEOF },
+    { 0, 0, IDENT },
+    { "do", 2, DO },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "this", 4, THISTOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "extends", 7, RESERVED },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "break", 5, BREAK },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "typeof", 6, TYPEOF },
+    { "default", 7, DEFAULT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "const", 5, CONSTTOKEN },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "import", 6, RESERVED },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { "catch", 5, CATCH },
+    { 0, 0, IDENT },
+    { "export", 6, RESERVED },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+    { 0, 0, IDENT },
+};
+
+} // namespace JSC
@@ -31,6 +31,18 @@
 
 namespace JSC {
 
+template <typename LexerType>
+static void* parseWithLexer(LexerType& lexer, JSGlobalData* globalData, const SourceCode& source, ParserArena& arena, int& lineNumber, bool& lexError)
+{
+    lexer.setCode(source, arena);
+
+    void* tree = jsCreateSyntaxTree(globalData, &source);
+    lineNumber = lexer.lineNumber();
+    lexError = lexer.sawError();
+    lexer.clear();
+    return tree;
+}
+
 void* Parser::createSyntaxTree(JSGlobalData* globalData, const SourceCode& source, int* errLine, UString* errMsg)
 {
     m_source = &source;
@@ -47,13 +59,13 @@ void* Parser::createSyntaxTree(JSGlobalData* globalData, const SourceCode& sourc
     *errLine = -1;
     *errMsg = UString();
 
-    Lexer& lexer = *globalData->lexer;
-    lexer.setCode(*m_source, m_arena);
-
-    void* tree = jsCreateSyntaxTree(globalData, m_source);
-    int lineNumber = lexer.lineNumber();
-    bool lexError = lexer.sawError();
-    lexer.clear();
+    int lineNumber;
+    bool lexError;
+    void* tree;
+    if (source.provider()->is8Bit())
+        tree = parseWithLexer(*globalData->lexer8, globalData, source, m_arena, lineNumber, lexError);
+    else
+        tree = parseWithLexer(*globalData->lexer16, globalData, source, m_arena, lineNumber, lexError);
 
     if (lexError) {
         *errLine = lineNumber;
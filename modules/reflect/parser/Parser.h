@@ -38,6 +38,10 @@ namespace JSC {
     class ScopeNode;
     class SourceElements;
 
+    // A parser, like the JSGlobalData owning it, is used by one thread at a
+    // time. Threads that each have their own JSGlobalData can parse at the
+    // same time: the only state they share is read-only, or locked (the
+    // powers of five cached by dtoa).
     class Parser : public Noncopyable {
     public:
 
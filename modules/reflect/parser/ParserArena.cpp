@@ -26,61 +26,160 @@
 #include "config.h"
 #include "ParserArena.h"
 
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 namespace JSC {
 
-ParserArena::ParserArena()
-    : m_freeableMemory(0)
-    , m_freeablePoolEnd(0)
-    , m_identifierArena(new IdentifierArena)
+IdentifierArena::IdentifierArena()
 {
+    m_table.fill(0, initialTableSize);
 }
 
-inline void* ParserArena::freeablePool()
+void IdentifierArena::clear()
 {
-    ASSERT(m_freeablePoolEnd);
-    return m_freeablePoolEnd - freeablePoolSize;
+    m_identifiers.clear();
+    m_table.fill(0);
 }
 
-inline void ParserArena::deallocateObjects()
+void IdentifierArena::expandTable()
 {
-    if (m_freeablePoolEnd)
-        free(freeablePool());
+    Vector<Entry*> table;
+    table.fill(0, m_table.size() * 2);
+    size_t mask = table.size() - 1;
+    size_t size = m_table.size();
+    for (size_t i = 0; i < size; ++i) {
+        Entry* entry = m_table[i];
+        if (!entry)
+            continue;
+        size_t index = entry->hash & mask;
+        while (table[index])
+            index = (index + 1) & mask;
+        table[index] = entry;
+    }
+    m_table.swap(table);
+}
 
-    size_t size = m_freeablePools.size();
-    for (size_t i = 0; i < size; ++i)
-        free(m_freeablePools[i]);
+ParserArena::ParserArena()
+    : m_freeableMemory(0)
+    , m_freeablePoolEnd(0)
+    , m_identifierArena(new IdentifierArena)
+    , m_currentPool(0)
+    , m_bytesInFullPools(0)
+    , m_bytesAllocated(0)
+    , m_peakBytes(0)
+{
 }
 
 ParserArena::~ParserArena()
 {
-    deallocateObjects();
+    size_t size = m_pools.size();
+    for (size_t i = 0; i < size; ++i)
+        destroyPool(m_pools[i]);
     delete m_identifierArena;
 }
 
+inline size_t ParserArena::bytesInUse() const
+{
+    if (m_currentPool == m_pools.size())
+        return m_bytesInFullPools;
+    return m_bytesInFullPools + (m_freeableMemory - m_pools[m_currentPool].memory);
+}
 
 void ParserArena::reset()
 {
-    // Since this code path is used only when parsing fails, it's not bothering to reuse
-    // any of the memory the arena allocated. We could improve that later if we want to
-    // efficiently reuse the same arena.
+    size_t used = bytesInUse();
+    m_bytesAllocated += used;
+    if (used > m_peakBytes)
+        m_peakBytes = used;
+
+    m_identifierArena->clear();
 
-    deallocateObjects();
+    size_t retained = 0;
+    size_t count = 0;
+    while (count < m_pools.size() && retained + m_pools[count].size <= maximumRetainedBytes)
+        retained += m_pools[count++].size;
+    for (size_t i = count; i < m_pools.size(); ++i)
+        destroyPool(m_pools[i]);
+    m_pools.shrink(count);
 
+    m_currentPool = m_pools.size();
+    m_bytesInFullPools = 0;
     m_freeableMemory = 0;
     m_freeablePoolEnd = 0;
-    m_identifierArena->clear();
-    m_freeablePools.clear();
 }
 
-void ParserArena::allocateFreeablePool()
+void ParserArena::allocateFreeablePool(size_t minimumSize)
+{
+    if (m_currentPool < m_pools.size())
+        m_bytesInFullPools += m_freeableMemory - m_pools[m_currentPool].memory;
+
+    // Reuse the next retained pool if it is large enough, otherwise insert a
+    // new one, larger than the previous pool, in front of it.
+    size_t next = m_currentPool == m_pools.size() ? 0 : m_currentPool + 1;
+    if (next == m_pools.size() || m_pools[next].size < minimumSize) {
+        size_t size = next ? std::min(m_pools[next - 1].size * 2, static_cast<size_t>(maximumPoolSize)) : initialPoolSize;
+        m_pools.insert(next, createPool(std::max(size, minimumSize)));
+    }
+
+    m_currentPool = next;
+    m_freeableMemory = m_pools[next].memory;
+    m_freeablePoolEnd = m_freeableMemory + m_pools[next].size;
+}
+
+ParserArena::Pool ParserArena::createPool(size_t size)
 {
-    if (m_freeablePoolEnd)
-        m_freeablePools.append(freeablePool());
+    Pool pool;
+    pool.size = size;
+    pool.mapped = false;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (size >= hugePagePoolSize) {
+        size = (size + hugePagePoolSize - 1) & ~(hugePagePoolSize - 1);
+        void* memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            madvise(memory, size, MADV_HUGEPAGE);
+            pool.memory = static_cast<char*>(memory);
+            pool.size = size;
+            pool.mapped = true;
+            return pool;
+        }
+    }
+#endif
+    pool.memory = static_cast<char*>(malloc(size));
+    if (!pool.memory)
+        CRASH();
+    return pool;
+}
 
-    char* pool = static_cast<char*>(malloc(freeablePoolSize));
-    m_freeableMemory = pool;
-    m_freeablePoolEnd = pool + freeablePoolSize;
-    ASSERT(freeablePool() == pool);
+void ParserArena::destroyPool(const Pool& pool)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (pool.mapped) {
+        munmap(pool.memory, pool.size);
+        return;
+    }
+#endif
+    free(pool.memory);
+}
+
+ParserArenaStatistics ParserArena::statistics() const
+{
+    ParserArenaStatistics statistics;
+    size_t used = bytesInUse();
+    statistics.bytesAllocated = m_bytesAllocated + used;
+    statistics.peakBytes = std::max(m_peakBytes, used);
+    statistics.poolBytes = 0;
+    statistics.pools = m_pools.size();
+    statistics.hugePagePools = 0;
+    for (size_t i = 0; i < m_pools.size(); ++i) {
+        statistics.poolBytes += m_pools[i].size;
+        if (m_pools[i].mapped)
+            ++statistics.hugePagePools;
+    }
+    return statistics;
 }
 
 }
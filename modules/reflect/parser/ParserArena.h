@@ -35,31 +35,96 @@ namespace JSC {
 
     class JSGlobalData;
 
+    // Interns the identifiers of a parse: the same name always gives the same
+    // Identifier, so the parser can compare the identifiers it gets from the
+    // lexer by address, and their characters are stored once.
     class IdentifierArena {
     public:
-        ALWAYS_INLINE const Identifier& makeIdentifier(JSGlobalData*, const UChar* characters, size_t length);
+        struct Entry {
+            template <typename CharType>
+            Entry(JSGlobalData* globalData, const CharType* characters, size_t length, unsigned hash)
+                : identifier(globalData, characters, length)
+                , hash(hash)
+                , token(-1)
+            {
+            }
+
+            Identifier identifier;
+            unsigned hash;
+            // Token type the lexer classified the name as, -1 until it does.
+            int token;
+        };
+
+        IdentifierArena();
+
+        // Latin-1 and UTF-16 spellings of the same name give the same entry.
+        template <typename CharType>
+        ALWAYS_INLINE Entry& intern(JSGlobalData*, const CharType* characters, size_t length);
+        template <typename CharType>
+        const Identifier& makeIdentifier(JSGlobalData* globalData, const CharType* characters, size_t length) { return intern(globalData, characters, length).identifier; }
         const Identifier& makeNumericIdentifier(JSGlobalData*, double number);
 
-        void clear() { m_identifiers.clear(); }
+        void clear();
         bool isEmpty() const { return m_identifiers.isEmpty(); }
 
     private:
-        typedef SegmentedVector<Identifier, 64> IdentifierVector;
+        static const size_t initialTableSize = 256;
+
+        template <typename CharType>
+        static unsigned hash(const CharType* characters, size_t length)
+        {
+            // FNV-1a
+            unsigned result = 2166136261U;
+            for (size_t i = 0; i < length; ++i)
+                result = (result ^ characters[i]) * 16777619U;
+            return result;
+        }
+
+        void expandTable();
+
+        typedef SegmentedVector<Entry, 64> IdentifierVector;
         IdentifierVector m_identifiers;
+        Vector<Entry*> m_table;
     };
 
-    ALWAYS_INLINE const Identifier& IdentifierArena::makeIdentifier(JSGlobalData* globalData, const UChar* characters, size_t length)
+    template <typename CharType>
+    ALWAYS_INLINE IdentifierArena::Entry& IdentifierArena::intern(JSGlobalData* globalData, const CharType* characters, size_t length)
     {
-        m_identifiers.append(Identifier(globalData, characters, length));
-        return m_identifiers.last();
+        unsigned h = hash(characters, length);
+        size_t mask = m_table.size() - 1;
+        size_t index = h & mask;
+        while (Entry* entry = m_table[index]) {
+            if (entry->hash == h && entry->identifier.length() == static_cast<int>(length)) {
+                const Identifier& identifier = entry->identifier;
+                if (identifier.is8Bit() ? equalCharacters(identifier.characters8(), characters, length) : equalCharacters(identifier.characters16(), characters, length))
+                    return *entry;
+            }
+            index = (index + 1) & mask;
+        }
+
+        m_identifiers.append(Entry(globalData, characters, length, h));
+        Entry* entry = &m_identifiers.last();
+        m_table[index] = entry;
+        if (m_identifiers.size() * 2 > m_table.size())
+            expandTable();
+        return *entry;
     }
 
     inline const Identifier& IdentifierArena::makeNumericIdentifier(JSGlobalData* globalData, double number)
     {
-        m_identifiers.append(Identifier(globalData, UString::number(number)));
-        return m_identifiers.last();
+        UString name = UString::number(number);
+        return makeIdentifier(globalData, name.characters8(), name.length());
     }
 
+    // Counters describing the memory use of a ParserArena.
+    struct ParserArenaStatistics {
+        size_t bytesAllocated; // handed out, over all the parses so far
+        size_t peakBytes; // handed out during the largest parse
+        size_t poolBytes; // held in pools right now
+        size_t pools;
+        size_t hugePagePools;
+    };
+
     class ParserArena : Noncopyable {
     public:
         ParserArena();
@@ -68,22 +133,37 @@ namespace JSC {
         void* allocateFreeable(size_t size)
         {
             ASSERT(size);
-            ASSERT(size <= freeablePoolSize);
             size_t alignedSize = alignSize(size);
-            ASSERT(alignedSize <= freeablePoolSize);
             if (UNLIKELY(static_cast<size_t>(m_freeablePoolEnd - m_freeableMemory) < alignedSize))
-                allocateFreeablePool();
+                allocateFreeablePool(alignedSize);
             void* block = m_freeableMemory;
             m_freeableMemory += alignedSize;
             return block;
         }
 
+        // Releases everything allocated so far. The pools are kept (up to
+        // maximumRetainedBytes) and filled again, in the same order, by the
+        // next parse.
         void reset();
 
         IdentifierArena& identifierArena() { return *m_identifierArena; }
 
+        ParserArenaStatistics statistics() const;
+
     private:
-        static const size_t freeablePoolSize = 8000;
+        // Pools grow geometrically from initialPoolSize to maximumPoolSize;
+        // a larger allocation gets a pool of its own size. Pools of at least
+        // hugePagePoolSize are mapped so that they can use huge pages.
+        static const size_t initialPoolSize = 16 * 1024;
+        static const size_t maximumPoolSize = 4 * 1024 * 1024;
+        static const size_t hugePagePoolSize = 2 * 1024 * 1024;
+        static const size_t maximumRetainedBytes = 16 * 1024 * 1024;
+
+        struct Pool {
+            char* memory;
+            size_t size;
+            bool mapped;
+        };
 
         static size_t alignSize(size_t size)
         {
@@ -94,15 +174,23 @@ namespace JSC {
             return (size + sizeof(AllocAlignmentInteger) - 1) & ~(sizeof(AllocAlignmentInteger) - 1);
         }
 
-        void* freeablePool();
-        void allocateFreeablePool();
-        void deallocateObjects();
+        size_t bytesInUse() const;
+        void allocateFreeablePool(size_t minimumSize);
+        static Pool createPool(size_t size);
+        static void destroyPool(const Pool&);
 
         char* m_freeableMemory;
         char* m_freeablePoolEnd;
 
         IdentifierArena* m_identifierArena;
-        Vector<void*> m_freeablePools;
+        Vector<Pool> m_pools;
+        // Index of the pool being filled (m_pools.size() when there is none)
+        // and the bytes handed out from the pools before it.
+        size_t m_currentPool;
+        size_t m_bytesInFullPools;
+
+        size_t m_bytesAllocated;
+        size_t m_peakBytes;
     };
 
 }
@@ -59,7 +59,6 @@ namespace JSC {
         SourceProvider* provider() const { return m_provider; }
         int startOffset() const { return m_startChar; }
         int endOffset() const { return m_endChar; }
-        const UChar* data() const { return m_provider->data() + m_startChar; }
         int length() const { return m_endChar - m_startChar; }
 
     private:
@@ -74,6 +73,16 @@ namespace JSC {
         return SourceCode(new UStringSourceProvider(source, url));
     }
 
+    inline SourceCode makeSource(const LChar* characters, int length, const UString& url = UString())
+    {
+        return SourceCode(new CharactersSourceProvider(characters, length, url));
+    }
+
+    inline SourceCode makeSource(const UChar* characters, int length, const UString& url = UString())
+    {
+        return SourceCode(new CharactersSourceProvider(characters, length, url));
+    }
+
 } // namespace JSC
 
 #endif // SourceCode_h
@@ -42,8 +42,14 @@ namespace JSC {
         }
         virtual ~SourceProvider() { }
 
-        virtual const UChar* data() const = 0;
+        // The source is either one byte per character (Latin-1) or UTF-16;
+        // only the accessor matching is8Bit() may be used.
+        virtual bool is8Bit() const = 0;
+        virtual const LChar* data8() const = 0;
+        virtual const UChar* data16() const = 0;
         virtual int length() const = 0;
+
+        template <typename CharType> const CharType* data() const;
         
         const UString& url() { return m_url; }
         intptr_t asID() { return reinterpret_cast<intptr_t>(this); }
@@ -56,6 +62,9 @@ namespace JSC {
         bool m_validated;
     };
 
+    template <> inline const LChar* SourceProvider::data<LChar>() const { return data8(); }
+    template <> inline const UChar* SourceProvider::data<UChar>() const { return data16(); }
+
     class UStringSourceProvider : public SourceProvider {
     public:
         UStringSourceProvider(const UString& source, const UString& url)
@@ -64,13 +73,46 @@ namespace JSC {
         {
         }
 
-        const UChar* data() const { return m_source.characters(); }
+        bool is8Bit() const { return m_source.is8Bit(); }
+        const LChar* data8() const { return m_source.characters8(); }
+        const UChar* data16() const { return m_source.characters16(); }
         int length() const { return m_source.length(); }
 
     private:
         UString m_source;
     };
-    
+
+    // Reads characters owned by the caller, which must keep them alive (and
+    // unchanged) for as long as the provider is used.
+    class CharactersSourceProvider : public SourceProvider {
+    public:
+        CharactersSourceProvider(const LChar* characters, int length, const UString& url)
+            : SourceProvider(url)
+            , m_characters8(characters)
+            , m_characters16(0)
+            , m_length(length)
+        {
+        }
+
+        CharactersSourceProvider(const UChar* characters, int length, const UString& url)
+            : SourceProvider(url)
+            , m_characters8(0)
+            , m_characters16(characters)
+            , m_length(length)
+        {
+        }
+
+        bool is8Bit() const { return !m_characters16; }
+        const LChar* data8() const { return m_characters8; }
+        const UChar* data16() const { return m_characters16; }
+        int length() const { return m_length; }
+
+    private:
+        const LChar* m_characters8;
+        const UChar* m_characters16;
+        int m_length;
+    };
+
 } // namespace JSC
 
 #endif // SourceProvider_h
@@ -35,7 +35,6 @@ namespace JSC {
 
 class Identifier;
 class JSGlobalData;
-class Lexer;
 
 namespace SyntaxTree {
 
@@ -47,6 +46,9 @@ public:
     virtual void process(Node* n) = 0;
 };
 
+// A syntax tree node lives entirely in the ParserArena: its child array is
+// allocated there too and it points to its names in the IdentifierArena, so
+// it owns nothing and is never destructed, the arena reset frees it.
 class Node
 {
 public:
@@ -180,7 +182,7 @@ public:
         case OpLShift:      op = AssignLeftShift; break;
         case OpRShift:      op = AssignRightShift; break;
         case OpURShift:     op = AssignZeroFillRightShift; break;
-        default: CRASH(); break;
+        default: ASSERT_NOT_REACHED(); break;
         }
         return op;
     }
@@ -225,141 +227,207 @@ public:
         case XOREQUAL:     op = AssignXor; break;
         case OREQUAL:      op = AssignOr; break;
         case MODEQUAL:     op = AssignModulus; break;
-        default: CRASH(); break;
+        default: ASSERT_NOT_REACHED(); break;
         }
         return op;
     }
 
     int type() const { return m_type; }
 
-    void append(Node* n) { m_children.append(n); }
+    void append(ParserArena& arena, Node* n)
+    {
+        if (m_childCount == m_childCapacity)
+            growChildren(arena);
+        m_children[m_childCount++] = n;
+    }
 
-    int childCount() const { return m_children.size(); }
+    int childCount() const { return m_childCount; }
 
-    Node* childAt(int i) const { return m_children.at(i); }
+    Node* childAt(int i) const
+    {
+        ASSERT(i >= 0 && static_cast<unsigned>(i) < m_childCount);
+        return m_children[i];
+    }
 
     void apply(Visitor* visitor) { visitor->process(this); }
 
-    Node(Type type)
+    explicit Node(Type type, OperatorType op = NoOperator)
         : m_type(type)
-        , m_operator(NoOperator)
-        , m_boolean(false)
-        , m_number(0)
+        , m_operator(op)
         , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
+        , m_boolean(false)
+        , m_start(0)
+        , m_end(0)
+        , m_childCount(0)
+        , m_childCapacity(0)
+        , m_children(0)
     {
+        m_payload.names.identifier = 0;
+        m_payload.names.string = 0;
     }
 
     explicit Node(bool b)
         : m_type(BooleanExpressionType)
         , m_operator(NoOperator)
-        , m_boolean(b)
-        , m_number(0)
         , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
+        , m_boolean(b)
+        , m_start(0)
+        , m_end(0)
+        , m_childCount(0)
+        , m_childCapacity(0)
+        , m_children(0)
     {
+        m_payload.names.identifier = 0;
+        m_payload.names.string = 0;
     }
 
     explicit Node(double d)
         : m_type(NumberExpressionType)
         , m_operator(NoOperator)
-        , m_boolean(false)
-        , m_number(d)
         , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
-    {
-    }
-
-    explicit Node(const UString &str)
-        : m_type(StringExpressionType)
-        , m_operator(NoOperator)
         , m_boolean(false)
-        , m_number(0)
-        , m_string(str)
-        , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
+        , m_start(0)
+        , m_end(0)
+        , m_childCount(0)
+        , m_childCapacity(0)
+        , m_children(0)
     {
+        m_payload.number = d;
     }
 
-    explicit Node(Type type, OperatorType op)
+    // The identifiers must outlive the node: they come from the
+    // IdentifierArena or the CommonIdentifiers.
+    Node(Type type, const Identifier& id)
         : m_type(type)
-        , m_operator(op)
-        , m_boolean(false)
-        , m_number(0)
+        , m_operator(NoOperator)
         , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
-    {
-    }
-
-    explicit Node(Type type, const Identifier& id)
-        : m_type(type)
         , m_boolean(false)
-        , m_number(0)
-        , m_identifier(id)
-        , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
+        , m_start(0)
+        , m_end(0)
+        , m_childCount(0)
+        , m_childCapacity(0)
+        , m_children(0)
     {
+        m_payload.names.identifier = &id;
+        m_payload.names.string = type == StringExpressionType ? &id : 0;
     }
 
-    explicit Node(Type type, const Identifier& pattern, const Identifier& flags)
+    Node(Type type, const Identifier& pattern, const Identifier& flags)
         : m_type(type)
-        , m_boolean(false)
-        , m_number(0)
-        , m_string(flags.ustring())
-        , m_identifier(pattern)
+        , m_operator(NoOperator)
         , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
-    {
-    }
-
-    explicit Node(Type type, Node* expr)
-        : m_type(type)
         , m_boolean(false)
-        , m_number(0)
-        , m_propertyType(PropertyNode::Constant)
-        , start(0)
-        , end(0)
+        , m_start(0)
+        , m_end(0)
+        , m_childCount(0)
+        , m_childCapacity(0)
+        , m_children(0)
     {
-        m_children.append(expr);
+        m_payload.names.identifier = &pattern;
+        m_payload.names.string = &flags;
     }
 
-    const Identifier& identifier() const { return m_identifier; }
+    const Identifier& identifier() const { return hasNames() && m_payload.names.identifier ? *m_payload.names.identifier : emptyIdentifier(); }
 
     bool boolean() const { return m_boolean; }
 
-    double number() const { return m_number; }
+    double number() const { return m_type == NumberExpressionType ? m_payload.number : 0; }
 
-    UString string() const { return m_string; }
+    const UString& string() const { return (hasNames() && m_payload.names.string ? *m_payload.names.string : emptyIdentifier()).ustring(); }
 
-    OperatorType op() const { return m_operator; }
+    OperatorType op() const { return static_cast<OperatorType>(m_operator); }
 
-    PropertyNode::Type propertyType() const { return m_propertyType; }
+    PropertyNode::Type propertyType() const { return static_cast<PropertyNode::Type>(m_propertyType); }
 
     void setPropertyType(PropertyNode::Type type) { m_propertyType = type; }
 
+    // Offsets (in UTF-16 code units) of the first character of the node in
+    // the source and of the character just after it.
+    int start() const { return m_start; }
+    int end() const { return m_end; }
+    bool hasRange() const { return m_end > m_start; }
+    void setRange(int start, int end) { m_start = start; m_end = end; }
+
 private:
-    Type m_type;
-    OperatorType m_operator;
+    bool hasNames() const { return m_type != NumberExpressionType; }
+
+    static const Identifier& emptyIdentifier()
+    {
+        static const Identifier empty;
+        return empty;
+    }
+
+    // Nodes of a fixed shape get a child array of the right size right away,
+    // lists start with a few entries and double when they are full. A grown
+    // list leaves its previous array unused in the arena.
+    static unsigned initialChildCapacity(int type)
+    {
+        switch (type) {
+        case ArgumentsListType:
+        case ClauseListType:
+        case CommaType:
+        case ConstDeclarationType:
+        case ElementListType:
+        case ForLoopType:
+        case PropertyListType:
+        case SourceElementsType:
+        case SwitchStatementType:
+            return 4;
+        case ConditionalExpressionType:
+        case ForInLoopType:
+        case IfStatementType:
+        case TryStatementType:
+            return 3;
+        case AssignmentExpressionType:
+        case BinaryExpressionType:
+        case BracketAccessType:
+        case ClauseType:
+        case DoWhileStatementType:
+        case FunctionCallType:
+        case FunctionDeclStatementType:
+        case FunctionExpressionType:
+        case NewExpressionType:
+        case WhileStatementType:
+        case WithStatementType:
+            return 2;
+        default:
+            return 1;
+        }
+    }
+
+    void growChildren(ParserArena& arena)
+    {
+        unsigned capacity = m_childCapacity ? m_childCapacity * 2 : initialChildCapacity(m_type);
+        Node** children = static_cast<Node**>(arena.allocateFreeable(capacity * sizeof(Node*)));
+        if (m_childCount)
+            memcpy(children, m_children, m_childCount * sizeof(Node*));
+        m_children = children;
+        m_childCapacity = capacity;
+    }
+
+    unsigned char m_type;
+    unsigned char m_operator;
+    unsigned char m_propertyType;
     bool m_boolean;
-    double m_number;
-    UString m_string;
-    Identifier m_identifier;
-    PropertyNode::Type m_propertyType;
-    int start;
-    int end;
-    WTF::Vector<Node*> m_children;
+    int m_start;
+    int m_end;
+    unsigned m_childCount;
+    unsigned m_childCapacity;
+    Node** m_children;
+    union {
+        double number;
+        struct {
+            // The identifier of the node, and the value of a string literal
+            // or the flags of a regular expression.
+            const Identifier* identifier;
+            const Identifier* string;
+        } names;
+    } m_payload;
 };
 
 class Builder {
 public:
-    Builder(JSGlobalData* globalData, Lexer*)
+    Builder(JSGlobalData* globalData)
         : m_globalData(globalData)
     {
     }
@@ -450,19 +518,19 @@ public:
     ConstDeclList appendConstDecl(ConstDeclList tail, const Identifier* name, Expression initializer)
     {
         Node* node = new (m_globalData) Node(Node::ConstDeclarationType, *name);
-        node->append(initializer);
-        tail->append(node);
+        append(node, initializer);
+        append(tail, node);
         return tail;
     }
 
     void appendStatement(SourceElements sourceElements, Statement statement)
     {
-        sourceElements->append(statement);
+        append(sourceElements, statement);
     }
 
     void appendToComma(Comma comma, Expression expr)
     {
-        comma->append(expr);
+        append(comma, expr);
     }
 
     void assignmentStackAppend(int& assignmentStackDepth, Expression node, int start, int divot, int assignmentCount, Operator op)
@@ -476,12 +544,12 @@ public:
         if (!list)
             return init;
         if (list->type() == Node::CommaType) {
-            list->append(init);
+            append(list, init);
             return list;
         }
         Node* node = new (m_globalData) Node(Node::CommaType);
-        node->append(list);
-        node->append(init);
+        append(node, list);
+        append(node, init);
         return node;
     }
 
@@ -492,17 +560,17 @@ public:
 
     Arguments createArguments(ArgumentsList argumentsList)
     {
-        return new (m_globalData) Node(Node::ArgumentsType, argumentsList);
+        return append(new (m_globalData) Node(Node::ArgumentsType), argumentsList);
     }
 
     ArgumentsList createArgumentsList(Expression expression)
     {
-        return new (m_globalData) Node(Node::ArgumentsListType, expression);
+        return append(new (m_globalData) Node(Node::ArgumentsListType), expression);
     }
 
     ArgumentsList createArgumentsList(ArgumentsList tail, Expression expression)
     {
-        tail->append(expression);
+        append(tail, expression);
         return tail;
     }
 
@@ -517,39 +585,42 @@ public:
     {
         // TODO: honor the elisions
         Node* node = new (m_globalData) Node(Node::ArrayType);
-        node->append(elements);
+        append(node, elements);
         return node;
     }
 
     Expression createArray(ElementList elements)
     {
         Node* node = new (m_globalData) Node(Node::ArrayType);
-        node->append(elements);
+        append(node, elements);
         return node;
     }
 
     Expression createAssignment(int& assignmentStackDepth, Expression rhs, int initialAssignmentCount, int currentAssignmentCount, int lastTokenEnd)
     {
         Node* node = new (m_globalData) Node(Node::AssignmentExpressionType, Node::convertOperator(m_assignmentInfoStack.last().m_op));
-        node->append(m_assignmentInfoStack.last().m_node);
-        node->append(rhs);
+        append(node, m_assignmentInfoStack.last().m_node);
+        append(node, rhs);
+        node->setRange(m_assignmentInfoStack.last().m_start, lastTokenEnd);
         m_assignmentInfoStack.removeLast();
         assignmentStackDepth--;
         return node;
     }
 
-    Expression createAssignResolve(const Identifier& ident, Expression rhs, bool rhsHasAssignment, int start, int divot, int end)
+    Expression createAssignResolve(const Identifier& ident, Expression rhs, bool rhsHasAssignment, int start, int identEnd, int divot, int end)
     {
         Expression lhs = new (m_globalData) Node(Node::IdentifierExpressionType, ident);
+        lhs->setRange(start, identEnd);
         Node* node = new (m_globalData) Node(Node::AssignmentExpressionType, Node::AssignEqual);
-        node->append(lhs);
-        node->append(rhs);
+        append(node, lhs);
+        append(node, rhs);
+        node->setRange(start, end);
         return node;
     }
 
     Statement createBlockStatement(SourceElements elements, int startLine, int endLine)
     {
-        return new (m_globalData) Node(Node::BlockStatementType, elements);
+        return append(new (m_globalData) Node(Node::BlockStatementType), elements);
     }
 
     Expression createBoolean(bool b)
@@ -560,8 +631,8 @@ public:
     Expression createBracketAccess(Expression base, Expression property, bool propertyHasAssignments, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::BracketAccessType);
-        node->append(base);
-        node->append(property);
+        append(node, base);
+        append(node, property);
         return node;
     }
 
@@ -577,42 +648,42 @@ public:
 
     Clause createClause(Expression expr, SourceElements elements)
     {
-        Node* node = new (m_globalData) Node(Node::ClauseType, expr);
-        node->append(elements);
+        Node* node = append(new (m_globalData) Node(Node::ClauseType), expr);
+        append(node, elements);
         return node;
     }
 
     ClauseList createClauseList(Clause clause)
     {
-        return new (m_globalData) Node(Node::ClauseListType, clause);
+        return append(new (m_globalData) Node(Node::ClauseListType), clause);
     }
 
     ClauseList createClauseList(ClauseList tail, Clause clause)
     {
-        tail->append(clause);
+        append(tail, clause);
         return tail;
     }
 
     Comma createCommaExpr(Expression lhs, Expression rhs)
     {
         Node* node = new (m_globalData) Node(Node::CommaType);
-        node->append(lhs);
-        node->append(rhs);
+        append(node, lhs);
+        append(node, rhs);
         return node;
     }
 
     Expression createConditionalExpr(Expression condition, Expression lhs, Expression rhs)
     {
         Node* node = new (m_globalData) Node(Node::ConditionalExpressionType);
-        node->append(condition);
-        node->append(lhs);
-        node->append(rhs);
+        append(node, condition);
+        append(node, lhs);
+        append(node, rhs);
         return node;
     }
 
     Statement createConstStatement(ConstDeclList decls, int startLine, int endLine)
     {
-        return new (m_globalData) Node(Node::ConstStatementType, decls);
+        return append(new (m_globalData) Node(Node::ConstStatementType), decls);
     }
 
     Statement createContinueStatement(int eStart, int eEnd, int startLine, int endLine)
@@ -633,28 +704,28 @@ public:
     Expression createDotAccess(Expression base, const Identifier& property, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::DotAccessType, property);
-        node->append(base);
+        append(node, base);
         return node;
     }
 
     Statement createDoWhileStatement(Statement statement, Expression expr, int startLine, int endLine)
     {
         Node* node = new (m_globalData) Node(Node::DoWhileStatementType);
-        node->append(statement);
-        node->append(expr);
+        append(node, statement);
+        append(node, expr);
         return node;
     }
 
     ElementList createElementList(int elisions, Expression expression)
     {
         // FIXME: honor the elision
-        return new (m_globalData) Node(Node::ElementListType, expression);
+        return append(new (m_globalData) Node(Node::ElementListType), expression);
     }
 
     ElementList createElementList(ElementList tail, int elisions, Expression expression)
     {
         // FIXME: honor the elision
-        tail->append(expression);
+        append(tail, expression);
         return tail;
     }
 
@@ -666,35 +737,35 @@ public:
     Statement createExprStatement(Expression expr, int start, int end)
     {
         Node* node = new (m_globalData) Node(Node::ExpressionStatementType);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Statement createForLoop(Expression initializer, Expression condition, Expression iter, Statement statements, bool b, int start, int end)
     {
         Node *node = new (m_globalData) Node(Node::ForLoopType);
-        node->append(initializer);
-        node->append(condition);
-        node->append(iter);
-        node->append(statements);
+        append(node, initializer);
+        append(node, condition);
+        append(node, iter);
+        append(node, statements);
         return node;
     }
 
     Statement createForInLoop(const Identifier* ident, Expression initializer, Expression iter, Statement statements, int start, int divot, int end, int initStart, int initEnd, int startLine, int endLine)
     {
         Node *node = new (m_globalData) Node(Node::ForInLoopType, *ident);
-        node->append(initializer);
-        node->append(iter);
-        node->append(statements);
+        append(node, initializer);
+        append(node, iter);
+        append(node, statements);
         return node;
     }
 
     Statement createForInLoop(Expression lhs, Expression iter, Statement statements, int eStart, int eDivot, int eEnd, int start, int end)
     {
         Node *node = new (m_globalData) Node(Node::ForInLoopType);
-        node->append(lhs);
-        node->append(iter);
-        node->append(statements);
+        append(node, lhs);
+        append(node, iter);
+        append(node, statements);
         return node;
     }
 
@@ -706,64 +777,66 @@ public:
     FormalParameterList createFormalParameterList(FormalParameterList tail, const Identifier& identifier)
     {
         Node* node = new (m_globalData) Node(Node::FormalParameterListType, identifier);
-        tail->append(node);
+        append(tail, node);
         return node;
     }
 
     Statement createFuncDeclStatement(const Identifier* name, FunctionBody body, FormalParameterList parameters, int openBracePos, int closeBracePos, int bodyStartLine, int bodyEndLine)
     {
         Node* node = new (m_globalData) Node(Node::FunctionDeclStatementType, *name);
-        node->append(parameters);
-        node->append(body);
+        append(node, parameters);
+        append(node, body);
         return node;
     }
 
     FunctionBody createFunctionBody(SourceElements elements = 0)
     {
-        return new (m_globalData) Node(Node::FunctionBodyType, elements);
+        return append(new (m_globalData) Node(Node::FunctionBodyType), elements);
     }
 
     Expression createFunctionExpr(const Identifier* name, FunctionBody body, FormalParameterList parameters, int openBracePos, int closeBracePos, int bodyStartLine, int bodyEndLine)
     {
         Node *node = new (m_globalData) Node(Node::FunctionExpressionType, *name);
-        node->append(parameters);
-        node->append(body);
+        append(node, parameters);
+        append(node, body);
         return node;
     }
 
     template <bool strict>
-    Property createGetterOrSetterProperty(PropertyNode::Type type, const Identifier* name, FormalParameterList parameterList, FunctionBody, int, int, int, int)
+    Property createGetterOrSetterProperty(PropertyNode::Type type, const Identifier* name, FormalParameterList parameterList, FunctionBody body, int openBracePos, int closeBracePos, int bodyStartLine, int bodyEndLine)
     {
-        CRASH();
-        return 0;
+        Node* node = new (m_globalData) Node(Node::PropertyType, *name);
+        node->setPropertyType(type);
+        append(node, createFunctionExpr(&m_globalData->propertyNames->nullIdentifier, body, parameterList, openBracePos, closeBracePos, bodyStartLine, bodyEndLine));
+        return node;
     }
 
     Statement createIfStatement(Expression condition, Statement trueBlock, int start, int end)
     {
-        Node *node = new (m_globalData) Node(Node::IfStatementType, condition);
-        node->append(trueBlock);
+        Node *node = append(new (m_globalData) Node(Node::IfStatementType), condition);
+        append(node, trueBlock);
         return node;
     }
 
     Statement createIfStatement(Expression condition, Statement trueBlock, Statement falseBlock, int start, int end)
     {
-        Node *node = new (m_globalData) Node(Node::IfStatementType, condition);
-        node->append(trueBlock);
-        node->append(falseBlock);
+        Node *node = append(new (m_globalData) Node(Node::IfStatementType), condition);
+        append(node, trueBlock);
+        append(node, falseBlock);
         return node;
     }
 
     Statement createLabelStatement(const Identifier* ident, Statement statement, int start, int end)
     {
         Node* node = new (m_globalData) Node(Node::LabelStatementType, *ident);
-        node->append(statement);
+        append(node, statement);
         return node;
     }
 
     Expression createLogicalNot(Expression expr)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::LogicalNotOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
@@ -775,20 +848,20 @@ public:
     Expression createObjectLiteral(PropertyList properties)
     {
         Node* node = new (m_globalData) Node(Node::ObjectLiteralType);
-        node->append(properties);
+        append(node, properties);
         return node;
     }
 
     Expression createNewExpr(Expression expr, Arguments arguments, int start, int divot, int end)
     {
-        Node* node = new (m_globalData) Node(Node::NewExpressionType, expr);
-        node->append(arguments);
+        Node* node = append(new (m_globalData) Node(Node::NewExpressionType), expr);
+        append(node, arguments);
         return node;
     }
 
     Expression createNewExpr(Expression expr, int start, int end)
     {
-        return new (m_globalData) Node(Node::ExpressionType, expr);
+        return append(new (m_globalData) Node(Node::ExpressionType), expr);
     }
 
     Expression createNull()
@@ -806,28 +879,28 @@ public:
     {
         Node* node = new (m_globalData) Node(Node::PropertyType, *name);
         node->setPropertyType(type);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     template <bool complete>
     Property createProperty(JSGlobalData* globalData, double name, Expression expr, PropertyNode::Type type)
     {
-        Identifier id(m_globalData->parser->arena().identifierArena().makeNumericIdentifier(m_globalData, name));
+        const Identifier& id = m_globalData->parser->arena().identifierArena().makeNumericIdentifier(m_globalData, name);
         Node* node = new (m_globalData) Node(Node::PropertyType, id);
         node->setPropertyType(type);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     PropertyList createPropertyList(Property property)
     {
-        return new (m_globalData) Node(Node::PropertyListType, property);
+        return append(new (m_globalData) Node(Node::PropertyListType), property);
     }
 
     PropertyList createPropertyList(Property property, PropertyList tail)
     {
-        tail->append(property);
+        append(tail, property);
         return tail;
     }
 
@@ -844,7 +917,7 @@ public:
 
     Statement createReturnStatement(Expression expression, int eStart, int eEnd, int startLine, int endLine)
     {
-        return new (m_globalData) Node(Node::ReturnStatementType, expression);
+        return append(new (m_globalData) Node(Node::ReturnStatementType), expression);
     }
 
     SourceElements createSourceElements()
@@ -854,55 +927,55 @@ public:
 
     Expression createString(const Identifier* string)
     {
-        return new (m_globalData) Node(string->ustring());
+        return new (m_globalData) Node(Node::StringExpressionType, *string);
     }
 
     Statement createSwitchStatement(Expression expr, ClauseList firstClauses, Clause defaultClause, ClauseList secondClauses, int startLine, int endLine)
     {
-        Node* node = new (m_globalData) Node(Node::SwitchStatementType, expr);
-        node->append(firstClauses);
-        node->append(defaultClause);
-        node->append(secondClauses);
+        Node* node = append(new (m_globalData) Node(Node::SwitchStatementType), expr);
+        append(node, firstClauses);
+        append(node, defaultClause);
+        append(node, secondClauses);
         return node;
     }
 
     Statement createThrowStatement(Expression expr, int start, int end, int startLine, int endLine)
     {
-        return new (m_globalData) Node(Node::ThrowStatementType, expr);
+        return append(new (m_globalData) Node(Node::ThrowStatementType), expr);
     }
 
     Statement createTryStatement(Statement tryBlock, const Identifier* ident, bool catchHasEval, Statement catchBlock, Statement finallyBlock, int startLine, int endLine)
     {
         Node* node = new (m_globalData) Node(Node::TryStatementType, *ident);
-        node->append(tryBlock);
-        node->append(catchBlock);
-        node->append(finallyBlock);
+        append(node, tryBlock);
+        append(node, catchBlock);
+        append(node, finallyBlock);
         return node;
     }
 
     Expression createUnaryPlus(Expression expr)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::AddOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Statement createVarStatement(Expression expr, int start, int end)
     {
-        return new (m_globalData) Node(Node::VariableDeclarationType, expr);
+        return append(new (m_globalData) Node(Node::VariableDeclarationType), expr);
     }
 
     Statement createWhileStatement(Expression expr, Statement statement, int startLine, int endLine)
     {
-        Node* node = new (m_globalData) Node(Node::WhileStatementType, expr);
-        node->append(statement);
+        Node* node = append(new (m_globalData) Node(Node::WhileStatementType), expr);
+        append(node, statement);
         return node;
     }
 
     Statement createWithStatement(Expression expr, Statement statement, int start, int end, int startLine, int endLine)
     {
-        Node* node = new (m_globalData) Node(Node::WithStatementType, expr);
-        node->append(statement);
+        Node* node = append(new (m_globalData) Node(Node::WithStatementType), expr);
+        append(node, statement);
         return node;
     }
 
@@ -941,58 +1014,59 @@ public:
     Expression makeBinaryNode(int token, pair<Expression, BinaryOpInfo> lhs, pair<Expression, BinaryOpInfo> rhs)
     {
         Node* node = new (m_globalData) Node(Node::BinaryExpressionType, Node::convertOperator(token));
-        node->append(lhs.first);
-        node->append(rhs.first);
+        append(node, lhs.first);
+        append(node, rhs.first);
+        node->setRange(lhs.first->start(), rhs.first->end());
         return node;
     }
 
     Expression makeBitwiseNotNode(Expression expr)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::BitwiseNotOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Expression makeDeleteNode(Expression expr, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::DeleteOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Expression makeFunctionCallNode(Expression func, Arguments args, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::FunctionCallType);
-        node->append(func);
-        node->append(args);
+        append(node, func);
+        append(node, args);
         return node;
     }
 
     Expression makeNegateNode(Expression expr)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::SubtractOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Expression makePostfixNode(Expression expr, Operator op, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::PostfixType, Node::convertOperator(op));
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Expression makePrefixNode(Expression expr, Operator op, int start, int divot, int end)
     {
         Node* node = new (m_globalData) Node(Node::PrefixType, Node::convertOperator(op));
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
     Expression makeTypeOfNode(Expression expr)
     {
         Node* node = new (m_globalData) Node(Node::UnaryExpressionType, Node::TypeofOperator);
-        node->append(expr);
+        append(node, expr);
         return node;
     }
 
@@ -1024,6 +1098,16 @@ public:
     {
     }
 
+    // Gives the node its source range, unless a more specific parse function
+    // already did (e.g. for a parenthesized expression, the range stays the
+    // one of the expression inside).
+    Node* setRange(Node* node, int start, int end)
+    {
+        if (node && !node->hasRange())
+            node->setRange(start, end);
+        return node;
+    }
+
     void shrinkOperandStackBy(int& operandStackDepth, int amount)
     {
         operandStackDepth -= amount;
@@ -1053,6 +1137,12 @@ public:
     }
 
 private:
+    Node* append(Node* node, Node* child)
+    {
+        node->append(m_globalData->parser->arena(), child);
+        return node;
+    }
+
     JSGlobalData* m_globalData;
     Vector<AssignmentInfo, 10> m_assignmentInfoStack;
     Vector<BinaryOperand, 10> m_binaryOperandStack;
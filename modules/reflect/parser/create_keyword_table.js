@@ -0,0 +1,132 @@
+/*global system:true, fs:true */
+
+// Generates Lexer.lut.h, the perfect hash table of the reserved words
+// recognized by Lexer. Run it with HammerJS from the top of the tree:
+//
+//     hammerjs modules/reflect/parser/create_keyword_table.js
+//
+// The hash only looks at the length and at the first, second and last
+// characters; the search below picks multipliers for which no two keywords
+// share a slot.
+
+var keywords = [
+    ['break', 'BREAK'],
+    ['case', 'CASE'],
+    ['catch', 'CATCH'],
+    ['const', 'CONSTTOKEN'],
+    ['continue', 'CONTINUE'],
+    ['debugger', 'DEBUGGER'],
+    ['default', 'DEFAULT'],
+    ['delete', 'DELETETOKEN'],
+    ['do', 'DO'],
+    ['else', 'ELSE'],
+    ['false', 'FALSETOKEN'],
+    ['finally', 'FINALLY'],
+    ['for', 'FOR'],
+    ['function', 'FUNCTION'],
+    ['if', 'IF'],
+    ['in', 'INTOKEN'],
+    ['instanceof', 'INSTANCEOF'],
+    ['new', 'NEW'],
+    ['null', 'NULLTOKEN'],
+    ['return', 'RETURN'],
+    ['switch', 'SWITCH'],
+    ['this', 'THISTOKEN'],
+    ['throw', 'THROW'],
+    ['true', 'TRUETOKEN'],
+    ['try', 'TRY'],
+    ['typeof', 'TYPEOF'],
+    ['var', 'VAR'],
+    ['void', 'VOIDTOKEN'],
+    ['while', 'WHILE'],
+    ['with', 'WITH'],
+
+    // Future reserved words.
+    ['class', 'RESERVED'],
+    ['enum', 'RESERVED'],
+    ['export', 'RESERVED'],
+    ['extends', 'RESERVED'],
+    ['import', 'RESERVED'],
+    ['super', 'RESERVED']
+];
+
+var tableSize = 128;
+
+function hash(word, multipliers) {
+    var first = word.charCodeAt(0),
+        second = word.charCodeAt(1),
+        last = word.charCodeAt(word.length - 1);
+    return (first * multipliers[0] + second * multipliers[1] + last * multipliers[2] + word.length) & (tableSize - 1);
+}
+
+function place(multipliers) {
+    var table = [], i, slot;
+    for (i = 0; i < keywords.length; i += 1) {
+        slot = hash(keywords[i][0], multipliers);
+        if (table[slot]) {
+            return null;
+        }
+        table[slot] = keywords[i];
+    }
+    return table;
+}
+
+function search() {
+    var a, b, c, table;
+    for (a = 1; a < tableSize; a += 1) {
+        for (b = 1; b < tableSize; b += 1) {
+            for (c = 1; c < tableSize; c += 1) {
+                table = place([a, b, c]);
+                if (table) {
+                    return { multipliers: [a, b, c], table: table };
+                }
+            }
+        }
+    }
+    throw new Error('No perfect hash for ' + tableSize + ' slots');
+}
+
+function generate() {
+    var result = search(),
+        m = result.multipliers,
+        minimumLength = 100,
+        maximumLength = 0,
+        lines = [],
+        i, entry;
+
+    keywords.forEach(function (keyword) {
+        minimumLength = Math.min(minimumLength, keyword[0].length);
+        maximumLength = Math.max(maximumLength, keyword[0].length);
+    });
+
+    lines.push('// Automatically generated by create_keyword_table.js. DO NOT EDIT.');
+    lines.push('');
+    lines.push('namespace JSC {');
+    lines.push('');
+    lines.push('static const int minimumKeywordLength = ' + minimumLength + ';');
+    lines.push('static const int maximumKeywordLength = ' + maximumLength + ';');
+    lines.push('');
+    lines.push('template <typename CharType>');
+    lines.push('static inline unsigned keywordHash(const CharType* characters, int length)');
+    lines.push('{');
+    lines.push('    return (characters[0] * ' + m[0] + 'u + characters[1] * ' + m[1] + 'u + characters[length - 1] * ' + m[2] + 'u + length) & ' + (tableSize - 1) + ';');
+    lines.push('}');
+    lines.push('');
+    lines.push('static const HashEntry keywordTable[' + tableSize + '] = {');
+    for (i = 0; i < tableSize; i += 1) {
+        entry = result.table[i];
+        if (entry) {
+            lines.push('    { "' + entry[0] + '", ' + entry[0].length + ', ' + entry[1] + ' },');
+        } else {
+            lines.push('    { 0, 0, IDENT },');
+        }
+    }
+    lines.push('};');
+    lines.push('');
+    lines.push('} // namespace JSC');
+    return lines.join('\n');
+}
+
+var f = fs.open('modules/reflect/parser/Lexer.lut.h', 'w');
+f.writeLine(generate());
+f.close();
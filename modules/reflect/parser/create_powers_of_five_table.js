@@ -0,0 +1,165 @@
+/*global system:true, fs:true */
+
+// Generates PowersOfFive.h, the 128-bit approximations of 5^q used by the
+// lexer to convert decimal literals to doubles (the Eisel-Lemire algorithm).
+// Run it with HammerJS from the top of the tree:
+//
+//     hammerjs modules/reflect/parser/create_powers_of_five_table.js
+//
+// For q >= 0 an entry holds the 128 most significant bits of 5^q, truncated.
+// For q < 0 it holds the 128 most significant bits of 2^b / 5^-q, rounded up.
+// Big numbers are arrays of 16-bit limbs, least significant first.
+
+var smallestPower = -342,
+    largestPower = 308,
+    limbBits = 16,
+    limbBase = 1 << limbBits;
+
+function bitLength(n) {
+    var top = n.length - 1, bits;
+    while (top >= 0 && n[top] === 0) {
+        top -= 1;
+    }
+    if (top < 0) {
+        return 0;
+    }
+    for (bits = 0; (n[top] >> bits) !== 0; bits += 1) {
+    }
+    return top * limbBits + bits;
+}
+
+function multiplySmall(n, factor) {
+    var result = [], carry = 0, i, value;
+    for (i = 0; i < n.length; i += 1) {
+        value = n[i] * factor + carry;
+        result.push(value % limbBase);
+        carry = Math.floor(value / limbBase);
+    }
+    while (carry) {
+        result.push(carry % limbBase);
+        carry = Math.floor(carry / limbBase);
+    }
+    return result;
+}
+
+function divideSmall(n, divisor) {
+    var result = [], remainder = 0, i, value;
+    for (i = n.length - 1; i >= 0; i -= 1) {
+        value = remainder * limbBase + n[i];
+        result[i] = Math.floor(value / divisor);
+        remainder = value % divisor;
+    }
+    return result;
+}
+
+function addOne(n) {
+    var result = n.slice(0), i = 0;
+    while (true) {
+        if (i === result.length) {
+            result.push(0);
+        }
+        result[i] += 1;
+        if (result[i] < limbBase) {
+            return result;
+        }
+        result[i] = 0;
+        i += 1;
+    }
+}
+
+function bit(n, index) {
+    var limb = Math.floor(index / limbBits);
+    return limb < n.length ? (n[limb] >> (index % limbBits)) & 1 : 0;
+}
+
+function power(exponent) {
+    var result = [], i;
+    for (i = 0; i <= Math.floor(exponent / limbBits); i += 1) {
+        result.push(0);
+    }
+    result[Math.floor(exponent / limbBits)] = 1 << (exponent % limbBits);
+    return result;
+}
+
+// The bits [shift, shift + 128) of n as two 64-bit hexadecimal literals.
+function hex128(n, shift) {
+    var words = [], w, nibble, digits, b, value;
+    for (w = 1; w >= 0; w -= 1) {
+        digits = '';
+        for (nibble = 15; nibble >= 0; nibble -= 1) {
+            value = 0;
+            for (b = 3; b >= 0; b -= 1) {
+                value = value * 2 + (shift + w * 64 + nibble * 4 + b >= 0 ? bit(n, shift + w * 64 + nibble * 4 + b) : 0);
+            }
+            digits += '0123456789abcdef'.charAt(value);
+        }
+        words.push('0x' + digits + 'ULL');
+    }
+    return words;
+}
+
+function generate() {
+    var lines = [], entries = [], q, n, z, b, c, length,
+        // floor(2^K / 5^n) is kept for every n by repeated division; K is
+        // larger than any b below.
+        precision = 1800,
+        scaled = power(precision),
+        reciprocals = [];
+
+    for (q = 1; q <= -smallestPower; q += 1) {
+        scaled = divideSmall(scaled, 5);
+        reciprocals[q] = scaled;
+    }
+
+    for (q = smallestPower; q < 0; q += 1) {
+        n = [1];
+        for (z = 0; z < -q; z += 1) {
+            n = multiplySmall(n, 5);
+        }
+        z = bitLength(n);
+        // 2^z >= 5^-q; 5^-q is never a power of two.
+        b = q >= -27 ? z + 127 : 2 * z + 128;
+        c = addOne(shiftRight(reciprocals[-q], precision - b));
+        length = bitLength(c);
+        entries.push(hex128(c, length - 128));
+    }
+
+    n = [1];
+    for (q = 0; q <= largestPower; q += 1) {
+        entries.push(hex128(n, bitLength(n) - 128));
+        n = multiplySmall(n, 5);
+    }
+
+    lines.push('// Automatically generated by create_powers_of_five_table.js. DO NOT EDIT.');
+    lines.push('');
+    lines.push('namespace JSC {');
+    lines.push('');
+    lines.push('static const int smallestPowerOfFive = ' + smallestPower + ';');
+    lines.push('static const int largestPowerOfFive = ' + largestPower + ';');
+    lines.push('');
+    lines.push('// High and low 64 bits of 5^q for q in [smallestPowerOfFive, largestPowerOfFive].');
+    lines.push('static const uint64_t powersOfFive[' + (2 * entries.length) + '] = {');
+    entries.forEach(function (entry) {
+        lines.push('    ' + entry[0] + ', ' + entry[1] + ',');
+    });
+    lines.push('};');
+    lines.push('');
+    lines.push('} // namespace JSC');
+    return lines.join('\n');
+}
+
+function shiftRight(n, count) {
+    var result = [], length = bitLength(n), i, limb, b;
+    for (i = 0; i * limbBits < length - count; i += 1) {
+        limb = 0;
+        for (b = limbBits - 1; b >= 0; b -= 1) {
+            limb = limb * 2 + bit(n, count + i * limbBits + b);
+        }
+        result.push(limb);
+    }
+    return result;
+}
+
+var f = fs.open('modules/reflect/parser/PowersOfFive.h', 'w');
+f.writeLine(generate());
+f.close();
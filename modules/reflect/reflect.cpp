@@ -23,13 +23,84 @@
 
 #include <v8.h>
 
+#if defined(WIN32) || defined(_WIN32)
+#define HAMMERJS_OS_WINDOWS
+#endif
+
+#include <CharacterScanner.h>
 #include <JSGlobalData.h>
 #include <SourceCode.h>
 #include <SyntaxTree.h>
 #include <UString.h>
 
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(HAMMERJS_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 using namespace v8;
 
+// Which location properties Reflect.parse attaches to the nodes it returns.
+// The line table holds the offset of the first character of every line and
+// is only built when 'loc' is requested.
+struct LocationOptions {
+    bool range;
+    bool loc;
+    std::vector<int> lineStarts;
+};
+
+static LocationOptions* locationOptions = 0;
+
+template <typename CharType>
+static void buildLineTable(const CharType* code, int length, std::vector<int>& lineStarts)
+{
+    lineStarts.push_back(0);
+    for (int i = 0; i < length; ++i) {
+        CharType c = code[i];
+        if (c == '\r' && i + 1 < length && code[i + 1] == '\n')
+            ++i;
+        if (c == '\n' || c == '\r' || c == 0x2028 || c == 0x2029)
+            lineStarts.push_back(i + 1);
+    }
+}
+
+static Handle<Object> convertPosition(int offset)
+{
+    const std::vector<int>& lineStarts = locationOptions->lineStarts;
+    int line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+    Handle<Object> position = Object::New();
+    position->Set(String::New("line"), Integer::New(line));
+    position->Set(String::New("column"), Integer::New(offset - lineStarts[line - 1]));
+    return position;
+}
+
+static void setLocation(Handle<Value> value, JSC::SyntaxTree::Node* n)
+{
+    if (!locationOptions || !n->hasRange() || !value->IsObject() || value->IsArray())
+        return;
+    Handle<Object> object = value->ToObject();
+    if (locationOptions->range) {
+        Handle<Array> range = Array::New(2);
+        range->Set(0, Integer::New(n->start()));
+        range->Set(1, Integer::New(n->end()));
+        object->Set(String::New("range"), range);
+    }
+    if (locationOptions->loc) {
+        Handle<Object> loc = Object::New();
+        loc->Set(String::New("start"), convertPosition(n->start()));
+        loc->Set(String::New("end"), convertPosition(n->end()));
+        object->Set(String::New("loc"), loc);
+    }
+}
+
 static const char* operatorAsText(JSC::SyntaxTree::Node::OperatorType op)
 {
     switch (op) {
@@ -74,9 +145,9 @@ static const char* operatorAsText(JSC::SyntaxTree::Node::OperatorType op)
     case JSC::SyntaxTree::Node::AssignAnd: return "&=";
     case JSC::SyntaxTree::Node::AssignXor: return "^=";
     case JSC::SyntaxTree::Node::AssignOr: return "|=";
-    default: CRASH(); break;
+    default: ASSERT_NOT_REACHED(); break;
     }
-    return 0;
+    return "";
 }
 
 Handle<Value> convertNode(JSC::SyntaxTree::Node*, int);
@@ -100,14 +171,37 @@ Handle<Value> convertChild(JSC::SyntaxTree::Node* n, int index, int indent)
 
 Handle<String> convertUString(const JSC::UString& ustring)
 {
-    return String::New(ustring.characters(), ustring.length());
+    if (!ustring.is8Bit())
+        return String::New(ustring.characters16(), ustring.length());
+
+    // String::New(const char*) takes UTF-8, so only pure ASCII goes through
+    // as is; Latin-1 above 0x7F is widened first.
+    const LChar* characters = ustring.characters8();
+    unsigned length = ustring.length();
+    for (unsigned i = 0; i < length; ++i) {
+        if (characters[i] >= 0x80) {
+            std::vector<uint16_t> widened(characters, characters + length);
+            return String::New(&widened[0], length);
+        }
+    }
+    return String::New(reinterpret_cast<const char*>(characters), length);
 }
 
+static Handle<Value> convertNodeType(JSC::SyntaxTree::Node*, int);
+
 Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
 {
     if (!n)
         return Null();
 
+    Handle<Value> value = convertNodeType(n, indent);
+    setLocation(value, n);
+    return value;
+}
+
+static Handle<Value> convertNodeType(JSC::SyntaxTree::Node* n, int indent)
+{
+
     if (n->type() == JSC::SyntaxTree::Node::ArgumentsType) {
         if (n->childCount() && n->childAt(0))
             return convertNode(n->childAt(0), indent);
@@ -328,6 +422,7 @@ Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
             Handle<Object> param = Object::New();
             param->Set(String::New("type"), String::New("Identifier"));
             param->Set(String::New("name"), convertUString(pnode->identifier().ustring()));
+            setLocation(param, pnode);
             params->Set(index++, param);
             // linked-list of parameter identifiers
             if (pnode->childCount() > 0)
@@ -423,7 +518,7 @@ Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
         Handle<Object> object = Object::New();
         object->Set(String::New("type"), String::New("Literal"));
         object->Set(String::New("objtype"), String::New("Number"));
-        object->Set(String::New("value"), Integer::New(n->number()));
+        object->Set(String::New("value"), Number::New(n->number()));
         return object;
     }
 
@@ -463,6 +558,10 @@ Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
         object->Set(String::New("type"), String::New("Property"));
         object->Set(String::New("key"), key);
         object->Set(String::New("value"), convertChild(n, 0, indent + 1));
+        if (n->propertyType() == JSC::PropertyNode::Getter)
+            object->Set(String::New("kind"), String::New("get"));
+        else if (n->propertyType() == JSC::PropertyNode::Setter)
+            object->Set(String::New("kind"), String::New("set"));
         return object;
     }
 
@@ -513,17 +612,21 @@ Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
         Handle<Object> object = Object::New();
         object->Set(String::New("type"), String::New("SwitchStatement"));
         object->Set(String::New("discriminant"), convertChild(n, 0, indent + 1));
-        if (n->childAt(1)) {
-            // fold 'default' clause into another
-            JSC::SyntaxTree::Node clauses(*n->childAt(1));
-            if (n->childAt(2))
-                clauses.append(n->childAt(2));
-            object->Set(String::New("cases"), convertNode(&clauses, indent + 1));
-        } else {
-            if (n->childAt(2)) {
-                object->Set(String::New("cases"), convertChildren(n->childAt(2), indent + 1));
+        // the clauses before 'default', the 'default' clause and the ones after it
+        Handle<Array> cases = Array::New();
+        int count = 0;
+        for (int index = 1; index < n->childCount(); ++index) {
+            JSC::SyntaxTree::Node* child = n->childAt(index);
+            if (!child)
+                continue;
+            if (child->type() == JSC::SyntaxTree::Node::ClauseListType) {
+                for (int clause = 0; clause < child->childCount(); ++clause)
+                    cases->Set(count++, convertNode(child->childAt(clause), indent + 2));
+            } else {
+                cases->Set(count++, convertNode(child, indent + 2));
             }
         }
+        object->Set(String::New("cases"), cases);
         return object;
     }
 
@@ -593,20 +696,428 @@ Handle<Value> convertNode(JSC::SyntaxTree::Node* n, int indent)
 
 static Handle<Value> reflect_parse(const Arguments& args)
 {
-    if (args.Length() != 1)
-        return ThrowException(String::New("Exception: Reflect.parse() accepts 1 argument"));
-
-    String::Utf8Value code(args[0]);
-    UChar *content = new UChar[code.length()];
-    for (int i = 0; i < code.length(); ++i)
-        content[i] = (*code)[i];
-    JSC::UString scriptCode = JSC::UString(content, code.length());
-    delete [] content;
-
-    JSC::JSGlobalData* globalData = new JSC::JSGlobalData;
-    JSC::SyntaxTree::Node* tree = reinterpret_cast<JSC::SyntaxTree::Node*>(globalData->parser->createSyntaxTree(globalData, JSC::makeSource(scriptCode)));
+    if (args.Length() < 1 || args.Length() > 2)
+        return ThrowException(String::New("Exception: Reflect.parse() accepts 1 or 2 arguments"));
+
+    // The lexer reads the characters of the string directly: in place for an
+    // external string, otherwise from a single flattened copy. A copy that
+    // fits in Latin-1 is narrowed in place and lexed as 8-bit characters.
+    Handle<String> source = args[0]->ToString();
+    UChar* buffer = 0;
+    const LChar* characters8 = 0;
+    const UChar* characters16 = 0;
+    int length;
+    if (source->IsExternalAscii()) {
+        String::ExternalAsciiStringResource* resource = source->GetExternalAsciiStringResource();
+        characters8 = reinterpret_cast<const LChar*>(resource->data());
+        length = resource->length();
+    } else if (source->IsExternal()) {
+        String::ExternalStringResource* resource = source->GetExternalStringResource();
+        characters16 = resource->data();
+        length = resource->length();
+    } else {
+        length = source->Length();
+        buffer = new UChar[length + 1];
+        source->Write(buffer);
+        if (JSC::narrowToLatin1(buffer, buffer + length, reinterpret_cast<LChar*>(buffer)))
+            characters8 = reinterpret_cast<const LChar*>(buffer);
+        else {
+            source->Write(buffer);
+            characters16 = buffer;
+        }
+    }
+
+    LocationOptions options;
+    options.range = false;
+    options.loc = false;
+    if (args.Length() > 1 && args[1]->IsObject()) {
+        Handle<Object> object = args[1]->ToObject();
+        options.range = object->Get(String::New("range"))->BooleanValue();
+        options.loc = object->Get(String::New("loc"))->BooleanValue();
+        if (options.loc) {
+            if (characters8)
+                buildLineTable(characters8, length, options.lineStarts);
+            else
+                buildLineTable(characters16, length, options.lineStarts);
+        }
+    }
+
+    JSC::JSGlobalData* globalData = static_cast<JSC::JSGlobalData*>(External::Unwrap(args.Data()));
+    JSC::SyntaxTree::Node* tree = reinterpret_cast<JSC::SyntaxTree::Node*>(globalData->parser->createSyntaxTree(globalData, characters8 ? JSC::makeSource(characters8, length) : JSC::makeSource(characters16, length)));
+    locationOptions = (options.range || options.loc) ? &options : 0;
     Handle<Value> result = tree ? convertNode(tree, 0) : ThrowException(String::New("Exception: Reflect.parse error!"));
-    delete globalData;
+    locationOptions = 0;
+    globalData->parser->arena().reset();
+    delete[] buffer;
+    return result;
+}
+
+// Decodes UTF-8 the way V8 does for fs, including 4-byte sequences which
+// become surrogate pairs. Malformed sequences give U+FFFD.
+static void decodeUTF8(const unsigned char* p, const unsigned char* end, std::vector<UChar>& result)
+{
+    result.clear();
+    result.reserve(end - p);
+    while (p < end) {
+        unsigned code = *p++;
+        if (code < 0x80) {
+            result.push_back(code);
+            continue;
+        }
+        int count;
+        unsigned minimum;
+        if (code >= 0xc2 && code < 0xe0) {
+            count = 1;
+            code &= 0x1f;
+            minimum = 0x80;
+        } else if (code >= 0xe0 && code < 0xf0) {
+            count = 2;
+            code &= 0x0f;
+            minimum = 0x800;
+        } else if (code >= 0xf0 && code < 0xf5) {
+            count = 3;
+            code &= 0x07;
+            minimum = 0x10000;
+        } else {
+            result.push_back(0xfffd);
+            continue;
+        }
+        int i = 0;
+        while (i < count && p + i < end && (p[i] & 0xc0) == 0x80) {
+            code = (code << 6) | (p[i] & 0x3f);
+            ++i;
+        }
+        p += i;
+        if (i < count || code < minimum || code > 0x10ffff) {
+            result.push_back(0xfffd);
+            continue;
+        }
+        if (code >= 0x10000) {
+            code -= 0x10000;
+            result.push_back(0xd800 | (code >> 10));
+            result.push_back(0xdc00 | (code & 0x3ff));
+        } else
+            result.push_back(code);
+    }
+}
+
+// The characters of a file being parsed. Pure ASCII is lexed straight from
+// the bytes read, anything else is decoded and narrowed back to Latin-1
+// into the same buffer when possible.
+struct SourceBuffer {
+    std::vector<char> bytes;
+    std::vector<UChar> characters16;
+    const LChar* characters8;
+    int length;
+
+    bool read(const char* fileName)
+    {
+        FILE* f = fopen(fileName, "rb");
+        if (!f)
+            return false;
+        bytes.clear();
+        char block[64 * 1024];
+        size_t count;
+        while ((count = fread(block, 1, sizeof(block), f)) > 0)
+            bytes.insert(bytes.end(), block, block + count);
+        bool ok = !ferror(f);
+        fclose(f);
+        if (!ok)
+            return false;
+
+        // An empty file is lexed from an empty (but valid) Latin-1 buffer,
+        // so that nothing below indexes an empty vector.
+        if (bytes.empty()) {
+            static const LChar empty[1] = { 0 };
+            characters8 = empty;
+            length = 0;
+            return true;
+        }
+
+        const unsigned char* begin = reinterpret_cast<const unsigned char*>(&bytes[0]);
+        const unsigned char* end = begin + bytes.size();
+        unsigned char combined = 0;
+        for (const unsigned char* p = begin; p < end; ++p)
+            combined |= *p;
+        if (combined < 0x80) {
+            characters8 = begin;
+            length = bytes.size();
+            return true;
+        }
+
+        decodeUTF8(begin, end, characters16);
+        length = characters16.size();
+        if (JSC::narrowToLatin1(&characters16[0], &characters16[0] + length, reinterpret_cast<LChar*>(&bytes[0])))
+            characters8 = reinterpret_cast<const LChar*>(&bytes[0]);
+        else
+            characters8 = 0;
+        return true;
+    }
+
+    JSC::SourceCode source() const
+    {
+        return characters8 ? JSC::makeSource(characters8, length) : JSC::makeSource(&characters16[0], length);
+    }
+};
+
+// One file of Reflect.parseFiles(). A worker fills it in, then the main
+// thread converts the tree while the worker waits: the tree lives in the
+// worker's arena and is only valid until the worker moves on.
+struct ParsedFile {
+    enum State { Pending, Parsed, Converted };
+
+    ParsedFile()
+        : state(Pending)
+        , error(0)
+        , tree(0)
+    {
+        options.range = false;
+        options.loc = false;
+    }
+
+    State state;
+    const char* error;
+    JSC::SyntaxTree::Node* tree;
+    LocationOptions options;
+};
+
+static void parseFile(JSC::JSGlobalData* globalData, const std::string& fileName, ParsedFile& file, SourceBuffer& buffer)
+{
+    if (!buffer.read(fileName.c_str())) {
+        file.error = "Exception: Reflect.parseFiles() can't read the file";
+        return;
+    }
+    if (file.options.loc) {
+        if (buffer.characters8)
+            buildLineTable(buffer.characters8, buffer.length, file.options.lineStarts);
+        else
+            buildLineTable(&buffer.characters16[0], buffer.length, file.options.lineStarts);
+    }
+    file.tree = reinterpret_cast<JSC::SyntaxTree::Node*>(globalData->parser->createSyntaxTree(globalData, buffer.source()));
+    if (!file.tree)
+        file.error = "Exception: Reflect.parseFiles() can't parse the file";
+}
+
+static Handle<Value> convertParsedFile(ParsedFile& file)
+{
+    if (file.error)
+        return Exception::Error(String::New(file.error));
+    locationOptions = (file.options.range || file.options.loc) ? &file.options : 0;
+    Handle<Value> tree = convertNode(file.tree, 0);
+    locationOptions = 0;
+    return tree;
+}
+
+// Work shared by the Reflect.parseFiles() threads. Each worker takes the next
+// unclaimed file, parses it with its own JSGlobalData and waits until the
+// main thread, which converts the files in order, is done with the tree.
+struct ParseJob {
+    const std::vector<std::string>* fileNames;
+    std::vector<ParsedFile>* files;
+    size_t next;
+#if defined(HAMMERJS_OS_WINDOWS)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE changed;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+#endif
+};
+
+static void lockJob(ParseJob* job)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    EnterCriticalSection(&job->lock);
+#else
+    pthread_mutex_lock(&job->lock);
+#endif
+}
+
+static void unlockJob(ParseJob* job)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    LeaveCriticalSection(&job->lock);
+#else
+    pthread_mutex_unlock(&job->lock);
+#endif
+}
+
+// Waits for another thread to change the state of a file. The job must be locked.
+static void waitJob(ParseJob* job)
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    SleepConditionVariableCS(&job->changed, &job->lock, INFINITE);
+#else
+    pthread_cond_wait(&job->changed, &job->lock);
+#endif
+}
+
+static void setFileState(ParseJob* job, size_t index, ParsedFile::State state)
+{
+    lockJob(job);
+    (*job->files)[index].state = state;
+#if defined(HAMMERJS_OS_WINDOWS)
+    WakeAllConditionVariable(&job->changed);
+#else
+    pthread_cond_broadcast(&job->changed);
+#endif
+    unlockJob(job);
+}
+
+static void waitForFileState(ParseJob* job, size_t index, ParsedFile::State state)
+{
+    lockJob(job);
+    while ((*job->files)[index].state != state)
+        waitJob(job);
+    unlockJob(job);
+}
+
+static size_t takeFile(ParseJob* job)
+{
+    lockJob(job);
+    size_t index = job->next++;
+    unlockJob(job);
+    return index;
+}
+
+#if defined(HAMMERJS_OS_WINDOWS)
+static DWORD WINAPI parseWorker(LPVOID data)
+#else
+static void* parseWorker(void* data)
+#endif
+{
+    ParseJob* job = static_cast<ParseJob*>(data);
+    JSC::JSGlobalData globalData;
+    SourceBuffer buffer;
+    for (size_t index = takeFile(job); index < job->fileNames->size(); index = takeFile(job)) {
+        parseFile(&globalData, (*job->fileNames)[index], (*job->files)[index], buffer);
+        setFileState(job, index, ParsedFile::Parsed);
+        waitForFileState(job, index, ParsedFile::Converted);
+        globalData.parser->arena().reset();
+    }
+    return 0;
+}
+
+static size_t processorCount()
+{
+#if defined(HAMMERJS_OS_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? count : 1;
+#endif
+}
+
+static Handle<Value> reflect_parseFiles(const Arguments& args)
+{
+    if (args.Length() < 1 || args.Length() > 2 || !args[0]->IsArray())
+        return ThrowException(String::New("Exception: Reflect.parseFiles() accepts an array of file names and an optional object"));
+
+    Handle<Array> names = Handle<Array>::Cast(args[0]);
+    std::vector<std::string> fileNames;
+    for (unsigned i = 0; i < names->Length(); ++i) {
+        String::Utf8Value name(names->Get(i));
+        fileNames.push_back(std::string(*name, name.length()));
+    }
+
+    std::vector<ParsedFile> files(fileNames.size());
+    size_t threadCount = processorCount();
+    if (args.Length() > 1 && args[1]->IsObject()) {
+        Handle<Object> object = args[1]->ToObject();
+        bool range = object->Get(String::New("range"))->BooleanValue();
+        bool loc = object->Get(String::New("loc"))->BooleanValue();
+        for (size_t i = 0; i < files.size(); ++i) {
+            files[i].options.range = range;
+            files[i].options.loc = loc;
+        }
+        Handle<Value> threads = object->Get(String::New("threads"));
+        if (!threads->IsUndefined()) {
+            if (!threads->IsNumber() || threads->IntegerValue() < 1)
+                return ThrowException(String::New("Exception: Reflect.parseFiles() needs a positive number of threads"));
+            threadCount = threads->IntegerValue();
+        }
+    }
+    threadCount = std::min(threadCount, fileNames.size());
+
+    Handle<Array> result = Array::New(fileNames.size());
+
+    // The workers do all the reading and parsing, the calling thread only
+    // builds the V8 objects, which must happen on the thread owning V8.
+    ParseJob job;
+    job.fileNames = &fileNames;
+    job.files = &files;
+    job.next = 0;
+#if defined(HAMMERJS_OS_WINDOWS)
+    InitializeCriticalSection(&job.lock);
+    InitializeConditionVariable(&job.changed);
+    std::vector<HANDLE> threads;
+    for (size_t i = 0; i < threadCount && threadCount > 1; ++i) {
+        HANDLE thread = CreateThread(NULL, 0, parseWorker, &job, 0, NULL);
+        if (thread)
+            threads.push_back(thread);
+    }
+#else
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.changed, NULL);
+    std::vector<pthread_t> threads;
+    for (size_t i = 0; i < threadCount && threadCount > 1; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, parseWorker, &job) == 0)
+            threads.push_back(thread);
+    }
+#endif
+
+    if (threads.empty()) {
+        // A single file, a single thread or no thread at all: parse in
+        // turn with the parser of the context.
+        JSC::JSGlobalData* globalData = static_cast<JSC::JSGlobalData*>(External::Unwrap(args.Data()));
+        SourceBuffer buffer;
+        for (size_t i = 0; i < files.size(); ++i) {
+            HandleScope scope;
+            parseFile(globalData, fileNames[i], files[i], buffer);
+            result->Set(i, convertParsedFile(files[i]));
+            globalData->parser->arena().reset();
+        }
+    } else {
+        for (size_t i = 0; i < files.size(); ++i) {
+            HandleScope scope;
+            waitForFileState(&job, i, ParsedFile::Parsed);
+            result->Set(i, convertParsedFile(files[i]));
+            setFileState(&job, i, ParsedFile::Converted);
+        }
+    }
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    for (size_t i = 0; i < threads.size(); ++i) {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+    DeleteCriticalSection(&job.lock);
+#else
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+    pthread_cond_destroy(&job.changed);
+    pthread_mutex_destroy(&job.lock);
+#endif
+    return result;
+}
+
+static Handle<Value> reflect_stats(const Arguments& args)
+{
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: Reflect.stats() accepts no argument"));
+
+    JSC::JSGlobalData* globalData = static_cast<JSC::JSGlobalData*>(External::Unwrap(args.Data()));
+    JSC::ParserArenaStatistics statistics = globalData->parser->arena().statistics();
+
+    Handle<Object> result = Object::New();
+    result->Set(String::New("bytesAllocated"), Number::New(statistics.bytesAllocated));
+    result->Set(String::New("peakBytes"), Number::New(statistics.peakBytes));
+    result->Set(String::New("poolBytes"), Number::New(statistics.poolBytes));
+    result->Set(String::New("pools"), Number::New(statistics.pools));
+    result->Set(String::New("hugePagePools"), Number::New(statistics.hugePagePools));
     return result;
 }
 
@@ -614,7 +1125,13 @@ void setup_Reflect(Handle<Object> object, Handle<Array> args)
 {
     Handle<FunctionTemplate> reflectObject = FunctionTemplate::New();
 
-    reflectObject->Set(String::New("parse"), FunctionTemplate::New(reflect_parse)->GetFunction());
+    // The parser (lexer buffers, arena pools, common identifiers) is created
+    // once for the context and reset after every call.
+    Handle<Value> globalData = External::Wrap(new JSC::JSGlobalData);
+
+    reflectObject->Set(String::New("parse"), FunctionTemplate::New(reflect_parse, globalData)->GetFunction());
+    reflectObject->Set(String::New("parseFiles"), FunctionTemplate::New(reflect_parseFiles, globalData)->GetFunction());
+    reflectObject->Set(String::New("stats"), FunctionTemplate::New(reflect_stats, globalData)->GetFunction());
 
     object->Set(String::New("Reflect"), reflectObject->GetFunction());
 }
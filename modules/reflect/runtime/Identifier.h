@@ -32,16 +32,19 @@ namespace JSC {
     public:
 
         Identifier() { }
+        Identifier(JSGlobalData*, const LChar* chars, size_t len): m_string(chars, len) { }
         Identifier(JSGlobalData*, const UChar* chars, size_t len): m_string(chars, len) { }
         Identifier(JSGlobalData*, const UString &id): m_string(id) { }
 
         const UString& ustring() const { return m_string; }
         const UString& impl() const { return m_string; }
 
-        const UChar* characters() const { return m_string.characters(); }
+        bool is8Bit() const { return m_string.is8Bit(); }
+        const LChar* characters8() const { return m_string.characters8(); }
+        const UChar* characters16() const { return m_string.characters16(); }
         int length() const { return m_string.length(); }
 
-        static bool equal(const Identifier& a, const Identifier& b) { return a.m_string == b.m_string; }
+        static bool equal(const Identifier& a, const Identifier& b) { return &a == &b || a.m_string == b.m_string; }
 
     private:
         UString m_string;
@@ -65,12 +65,14 @@ namespace JSC {
     class JSGlobalData
     {
     public:
-        Lexer* lexer;
+        Lexer<LChar>* lexer8;
+        Lexer<UChar>* lexer16;
         Parser* parser;
         CommonIdentifiers* propertyNames;
 
         JSGlobalData()
-            : lexer(new Lexer(this))
+            : lexer8(new Lexer<LChar>(this))
+            , lexer16(new Lexer<UChar>(this))
             , parser(new Parser)
             , propertyNames(new CommonIdentifiers(this))
         {
@@ -80,7 +82,8 @@ namespace JSC {
         {
             delete propertyNames;
             delete parser;
-            delete lexer;
+            delete lexer16;
+            delete lexer8;
         }
     };
 
@@ -244,8 +244,17 @@ double jsToNumber(const UString& s)
 {
     unsigned size = s.length();
 
+    // The literal scanners below read UTF-16; 8-bit strings are widened first.
+    Vector<UChar, 64> widened;
+    const UChar* characters;
+    if (s.is8Bit()) {
+        widened.append(s.characters8(), size);
+        characters = widened.data();
+    } else
+        characters = s.characters16();
+
     if (size == 1) {
-        UChar c = s.characters()[0];
+        UChar c = characters[0];
         if (isASCIIDigit(c))
             return c - '0';
         if (isStrWhiteSpace(c))
@@ -253,7 +262,7 @@ double jsToNumber(const UString& s)
         return NaN;
     }
 
-    const UChar* data = s.characters();
+    const UChar* data = characters;
     const UChar* end = data + size;
 
     // Skip leading white space.
@@ -25,96 +25,159 @@
 
 #include "config.h"
 #include <dtoa.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <wtf/AlwaysInline.h>
+#include <wtf/Assertions.h>
 
 namespace JSC {
 
+// Compares characters of possibly different widths.
+template <typename CharType1, typename CharType2>
+ALWAYS_INLINE bool equalCharacters(const CharType1* a, const CharType2* b, unsigned length)
+{
+    for (unsigned i = 0; i < length; ++i) {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+template <>
+ALWAYS_INLINE bool equalCharacters(const LChar* a, const LChar* b, unsigned length)
+{
+    return !memcmp(a, b, length);
+}
+
+template <>
+ALWAYS_INLINE bool equalCharacters(const UChar* a, const UChar* b, unsigned length)
+{
+    return !memcmp(a, b, length * sizeof(UChar));
+}
+
+// An immutable string. Strings of up to 16 bytes are stored in the object
+// itself; longer ones share a reference-counted buffer, so that copying a
+// string never copies its characters. The reference count is not atomic: a
+// string must not be shared between threads.
+//
+// A string whose characters all fit in Latin-1 is always stored with one
+// byte per character, any other string with UTF-16 code units. Because of
+// that the width is part of the value: strings of different widths are
+// never equal.
 class UString {
 public:
-    // Construct a null string, distinguishable from an empty string.
+    // Construct an empty string.
     UString()
         : m_length(0)
-        , m_data(0)
+        , m_is8Bit(true)
+        , m_isShared(false)
     {
     }
 
     ~UString()
     {
-        delete [] m_data;
+        release();
     }
 
     UString(const UString &other)
         : m_length(other.m_length)
-        , m_data(0)
+        , m_is8Bit(other.m_is8Bit)
+        , m_isShared(other.m_isShared)
     {
-        m_length = other.m_length;
-        if (m_length) {
-            m_data = new UChar[m_length];
-            memcpy(m_data, other.m_data, m_length * sizeof(UChar));
-        }
+        memcpy(m_inline8, other.m_inline8, sizeof(m_inline8));
+        if (m_isShared)
+            ++m_rep->refCount;
     }
 
     UString& operator=(const UString &other)
     {
-        if (&other != this) {
-            delete [] m_data;
-            m_data = 0;
-            m_length = other.m_length;
-            if (m_length) {
-                m_data = new UChar[m_length];
-                memcpy(m_data, other.m_data, m_length * sizeof(UChar));
-            }
-        }
+        if (other.m_isShared)
+            ++other.m_rep->refCount;
+        release();
+        m_length = other.m_length;
+        m_is8Bit = other.m_is8Bit;
+        m_isShared = other.m_isShared;
+        memcpy(m_inline8, other.m_inline8, sizeof(m_inline8));
         return *this;
     }
 
-    // Construct a string with UTF-16 data.
+    // Construct a string with UTF-16 data, narrowed if it is all Latin-1.
     UString(const UChar* characters, unsigned length)
         : m_length(0)
-        , m_data(0)
+        , m_is8Bit(true)
+        , m_isShared(false)
     {
-        if (characters && length) {
-            m_length = length;
-            m_data = new UChar[length];
-            memcpy(m_data, characters, length * sizeof(UChar));
+        if (!characters || !length)
+            return;
+        UChar combined = 0;
+        for (unsigned i = 0; i < length; ++i)
+            combined |= characters[i];
+        if (combined > 0xFF)
+            memcpy(allocate16(length), characters, length * sizeof(UChar));
+        else {
+            LChar* data = allocate8(length);
+            for (unsigned i = 0; i < length; ++i)
+                data[i] = static_cast<LChar>(characters[i]);
         }
     }
 
+    // Construct a string with latin1 data.
+    UString(const LChar* characters, unsigned length)
+        : m_length(0)
+        , m_is8Bit(true)
+        , m_isShared(false)
+    {
+        if (characters && length)
+            memcpy(allocate8(length), characters, length);
+    }
+
     // Construct a string with latin1 data, from a null-terminated source.
     UString(const char* characters)
         : m_length(0)
-        , m_data(0)
+        , m_is8Bit(true)
+        , m_isShared(false)
     {
         if (characters) {
-            m_length = strlen(characters);
-            m_data = new UChar[m_length];
-            for (unsigned i = 0; i < m_length; ++i)
-                m_data[i] = characters[i];
+            unsigned length = strlen(characters);
+            memcpy(allocate8(length), characters, length);
         }
     }
 
     // Construct a string with latin1 data.
     UString(const char* characters, unsigned length)
         : m_length(0)
-        , m_data(0)
+        , m_is8Bit(true)
+        , m_isShared(false)
     {
-        if (characters && length) {
-            m_length = length;
-            m_data = new UChar[m_length];
-            for (unsigned i = 0; i < m_length; ++i)
-                m_data[i] = characters[i];
-        }
+        if (characters && length)
+            memcpy(allocate8(length), characters, length);
     }
 
-    bool isEmpty() const { return !m_length || !m_data; }
+    bool isEmpty() const { return !m_length; }
 
     unsigned length() const { return m_length; }
 
-    const UChar* characters() const { return m_data; }
+    bool is8Bit() const { return m_is8Bit; }
 
-    UChar operator[](unsigned index) const { return (!m_data || index >= m_length) ? 0 : m_data[index]; }
+    const LChar* characters8() const
+    {
+        ASSERT(m_is8Bit);
+        return m_isShared ? m_rep->characters8() : m_inline8;
+    }
+
+    const UChar* characters16() const
+    {
+        ASSERT(!m_is8Bit);
+        return m_isShared ? m_rep->characters16() : m_inline16;
+    }
+
+    UChar operator[](unsigned index) const
+    {
+        if (index >= m_length)
+            return 0;
+        return m_is8Bit ? characters8()[index] : characters16()[index];
+    }
 
     static UString number(double d)
     {
@@ -125,24 +188,62 @@ public:
     }
 
 private:
+    static const unsigned inlineBytes = 16;
+
+    // Header of a shared buffer, the characters follow it.
+    struct Rep {
+        unsigned refCount;
+        LChar* characters8() { return reinterpret_cast<LChar*>(this + 1); }
+        UChar* characters16() { return reinterpret_cast<UChar*>(this + 1); }
+    };
+
+    void* allocate(unsigned length, unsigned characterSize)
+    {
+        m_length = length;
+        if (length * characterSize <= inlineBytes)
+            return m_inline8;
+        m_isShared = true;
+        m_rep = static_cast<Rep*>(malloc(sizeof(Rep) + length * characterSize));
+        m_rep->refCount = 1;
+        return m_rep + 1;
+    }
+
+    LChar* allocate8(unsigned length)
+    {
+        return static_cast<LChar*>(allocate(length, sizeof(LChar)));
+    }
+
+    UChar* allocate16(unsigned length)
+    {
+        m_is8Bit = false;
+        return static_cast<UChar*>(allocate(length, sizeof(UChar)));
+    }
+
+    void release()
+    {
+        if (m_isShared && !--m_rep->refCount)
+            free(m_rep);
+    }
+
     unsigned m_length;
-    UChar* m_data;
+    bool m_is8Bit;
+    bool m_isShared;
+    union {
+        Rep* m_rep;
+        LChar m_inline8[inlineBytes];
+        UChar m_inline16[inlineBytes / sizeof(UChar)];
+    };
 };
 
 ALWAYS_INLINE bool operator==(const UString& s1, const UString& s2)
 {
-    // If the lengths are not the same, we're done.
-    if (s1.length() != s2.length())
+    // If the lengths or the widths are not the same, we're done.
+    if (s1.length() != s2.length() || s1.is8Bit() != s2.is8Bit())
         return false;
 
-    // If they're the same rep, they're equal.
-    if (s1.characters() == s2.characters())
-        return true;
-
-    // At this point we know
-    //   (a) that the strings are the same length and
-    //   (b) that they are greater than zero length.
-    return memcmp(s1.characters(), s2.characters(), s1.length() * sizeof(UChar)) == 0;
+    if (s1.is8Bit())
+        return equalCharacters(s1.characters8(), s2.characters8(), s1.length());
+    return equalCharacters(s1.characters16(), s2.characters16(), s1.length());
 }
 
 
@@ -37,8 +37,11 @@
 #define COMPILE_ASSERT(exp, name)
 #endif
 
+// Aborts through assert() with a message. The build never defines NDEBUG,
+// so this is checked in every build; if it is compiled out, the code that
+// follows must still handle the case gracefully.
 #ifndef ASSERT_NOT_REACHED
-#define ASSERT_NOT_REACHED() do { CRASH(); } while(0)
+#define ASSERT_NOT_REACHED() ASSERT(!"ASSERT_NOT_REACHED")
 #endif
 
 #ifndef ASSERT_WITH_MESSAGE
@@ -34,6 +34,7 @@
 #include <stdint.h>
 #endif
 
+typedef unsigned char LChar;
 typedef uint16_t UChar;
 typedef uint32_t UChar32;
 
@@ -25,6 +25,7 @@
 
 #include <limits>
 #include <utility>
+#include <string.h>
 
 #include <wtf/AlwaysInline.h>
 #include <wtf/Assertions.h>
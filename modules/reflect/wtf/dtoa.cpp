@@ -134,6 +134,12 @@
 #include <float.h>
 #include <stdlib.h>
 
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 
 #if COMPILER(MSVC)
 #pragma warning(disable: 4244)
@@ -557,12 +563,24 @@ struct P5Node : Noncopyable {
     P5Node* next;
 };
     
+// The powers 5^(4 * 2^n) are computed on demand and shared by all threads.
+// Nodes are never modified once linked, so only growing the list is locked.
 static P5Node* p5s;
 static int p5sCount;
 
+#if defined(WIN32) || defined(_WIN32)
+static SRWLOCK p5sLock = SRWLOCK_INIT;
+static void lockP5s() { AcquireSRWLockExclusive(&p5sLock); }
+static void unlockP5s() { ReleaseSRWLockExclusive(&p5sLock); }
+#else
+static pthread_mutex_t p5sLock = PTHREAD_MUTEX_INITIALIZER;
+static void lockP5s() { pthread_mutex_lock(&p5sLock); }
+static void unlockP5s() { pthread_mutex_unlock(&p5sLock); }
+#endif
+
 static ALWAYS_INLINE void pow5mult(BigInt& b, int k)
 {
-    static int p05[3] = { 5, 25, 125 };
+    static const int p05[3] = { 5, 25, 125 };
 
     if (int i = k & 3)
         multadd(b, p05[i - 1], 0);
@@ -570,6 +588,7 @@ static ALWAYS_INLINE void pow5mult(BigInt& b, int k)
     if (!(k >>= 2))
         return;
 
+    lockP5s();
     P5Node* p5 = p5s;
 
     if (!p5) {
@@ -582,6 +601,7 @@ static ALWAYS_INLINE void pow5mult(BigInt& b, int k)
     }
 
     int p5sCountLocal = p5sCount;
+    unlockP5s();
     int p5sUsed = 0;
 
     for (;;) {
@@ -592,6 +612,7 @@ static ALWAYS_INLINE void pow5mult(BigInt& b, int k)
             break;
 
         if (++p5sUsed == p5sCountLocal) {
+            lockP5s();
             if (p5sUsed == p5sCount) {
                 ASSERT(!p5->next);
                 p5->next = new P5Node;
@@ -602,6 +623,7 @@ static ALWAYS_INLINE void pow5mult(BigInt& b, int k)
             }
             
             p5sCountLocal = p5sCount;
+            unlockP5s();
         }
         p5 = p5->next;
     }
@@ -27,18 +27,550 @@
 #define HAMMERJS_OS_WINDOWS
 #endif
 
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
 
 #ifdef HAMMERJS_OS_WINDOWS
+#include <io.h>
 #include <windows.h>
 #else
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define HAMMERJS_HAVE_SPAWN_CHDIR
+#endif
+extern char** environ;
 #endif
 
 using namespace v8;
 
+// Buffered writer for the standard output and error, used by system.print(),
+// system.write() and system.printErr() instead of a flushed std::endl per call.
+// The buffer goes out when it is full, on system.flush(), before running an
+// external command, before anything is written to the standard error (which
+// is flushed after every call), before an uncaught exception is reported, and
+// at exit. Output to a terminal is flushed after every call so that
+// interactive scripts behave as before.
+class OutputBuffer {
+public:
+    OutputBuffer(int fd)
+        : m_fd(fd)
+        , m_length(0)
+#ifdef HAMMERJS_OS_WINDOWS
+        , m_interactive(::_isatty(fd) != 0)
+#else
+        , m_interactive(::isatty(fd) != 0)
+#endif
+    {
+    }
+
+    void append(const char* data, size_t length)
+    {
+        if (m_length + length > sizeof(m_buffer)) {
+            flush();
+            if (length > sizeof(m_buffer)) {
+                writeData(data, length);
+                return;
+            }
+        }
+        memcpy(m_buffer + m_length, data, length);
+        m_length += length;
+    }
+
+    void append(char c)
+    {
+        if (m_length == sizeof(m_buffer))
+            flush();
+        m_buffer[m_length++] = c;
+    }
+
+    void commit()
+    {
+        if (m_interactive)
+            flush();
+    }
+
+    void flush()
+    {
+        if (!m_length)
+            return;
+        writeData(m_buffer, m_length);
+        m_length = 0;
+    }
+
+private:
+    void writeData(const char* data, size_t length)
+    {
+        // Whatever was written through iostreams (e.g. by the shell itself)
+        // must come out first.
+        if (m_fd == 1)
+            std::cout.flush();
+        else
+            std::cerr.flush();
+
+        while (length > 0) {
+#ifdef HAMMERJS_OS_WINDOWS
+            int count = ::_write(m_fd, data, length);
+#else
+            ssize_t count = ::write(m_fd, data, length);
+#endif
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            data += count;
+            length -= count;
+        }
+    }
+
+    int m_fd;
+    size_t m_length;
+    bool m_interactive;
+    char m_buffer[64 * 1024];
+};
+
+static OutputBuffer standardOutput(1);
+static OutputBuffer standardError(2);
+
+static void flushOutput()
+{
+    standardOutput.flush();
+    standardError.flush();
+}
+
+static void printArguments(OutputBuffer& output, const Arguments& args, bool newline)
+{
+    for (int i = 0; i < args.Length(); i++) {
+        String::Utf8Value value(args[i]);
+        output.append(*value, value.length());
+        if (i < args.Length() - 1)
+            output.append(' ');
+    }
+    if (newline)
+        output.append('\n');
+    output.commit();
+}
+
+#if !defined(HAMMERJS_OS_WINDOWS)
+
+// What to run and how, see system.spawn().
+struct SpawnOptions {
+    SpawnOptions()
+        : hasEnvironment(false)
+        , hasInput(false)
+        , captureOutput(true)
+        , captureError(true)
+    {
+    }
+
+    std::vector<std::string> arguments;
+    std::vector<std::string> environment;
+    std::string directory;
+    std::string input;
+    bool hasEnvironment;
+    bool hasInput;
+    bool captureOutput;
+    bool captureError;
+};
+
+// A child process started with posix_spawn (or fork and exec, if it must
+// change directory and posix_spawn can't), connected through pipes. The
+// parent ends of the pipes are not inherited by other children, so that
+// each pipe reaches end of file as soon as its own child is done.
+class ChildProcess {
+public:
+    ChildProcess()
+        : m_pid(-1)
+        , m_inputOffset(0)
+    {
+        m_pipes[0] = m_pipes[1] = m_pipes[2] = -1;
+    }
+
+    ~ChildProcess()
+    {
+        for (int i = 0; i < 3; ++i)
+            closePipe(i);
+    }
+
+    bool start(const SpawnOptions& options)
+    {
+        int pipes[3][2] = { { -1, -1 }, { -1, -1 }, { -1, -1 } };
+        bool wanted[3] = { options.hasInput, options.captureOutput, options.captureError };
+        bool ok = true;
+        for (int i = 0; i < 3; ++i) {
+            if (wanted[i] && !openPipe(pipes[i]))
+                ok = false;
+        }
+
+        std::vector<char*> argv;
+        for (size_t i = 0; i < options.arguments.size(); ++i)
+            argv.push_back(const_cast<char*>(options.arguments[i].c_str()));
+        argv.push_back(0);
+        std::vector<char*> envp;
+        for (size_t i = 0; i < options.environment.size(); ++i)
+            envp.push_back(const_cast<char*>(options.environment[i].c_str()));
+        envp.push_back(0);
+        char** environment = options.hasEnvironment ? &envp[0] : environ;
+
+        if (ok)
+            ok = spawn(options, pipes, &argv[0], environment);
+
+        // Keep the parent ends only.
+        for (int i = 0; i < 3; ++i) {
+            int childEnd = (i == 0) ? 0 : 1;
+            if (pipes[i][childEnd] >= 0)
+                ::close(pipes[i][childEnd]);
+            m_pipes[i] = pipes[i][1 - childEnd];
+        }
+        if (!ok) {
+            for (int i = 0; i < 3; ++i)
+                closePipe(i);
+            return false;
+        }
+
+        if (m_pipes[0] >= 0) {
+            m_input = options.input;
+            ::fcntl(m_pipes[0], F_SETFL, ::fcntl(m_pipes[0], F_GETFL) | O_NONBLOCK);
+        }
+        return true;
+    }
+
+    pid_t pid() const { return m_pid; }
+
+    // True once the input is written and the output pipes are at end of file.
+    bool isDrained() const { return m_pipes[0] < 0 && m_pipes[1] < 0 && m_pipes[2] < 0; }
+
+    void addPollEntries(std::vector<pollfd>& entries) const
+    {
+        for (int i = 0; i < 3; ++i) {
+            if (m_pipes[i] < 0)
+                continue;
+            pollfd entry;
+            entry.fd = m_pipes[i];
+            entry.events = (i == 0) ? POLLOUT : POLLIN;
+            entry.revents = 0;
+            entries.push_back(entry);
+        }
+    }
+
+    // Moves data for every pipe of this child which poll() found ready.
+    void handlePollEntries(const std::vector<pollfd>& entries)
+    {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (!entries[i].revents)
+                continue;
+            if (entries[i].fd == m_pipes[0])
+                writeInput();
+            else if (entries[i].fd == m_pipes[1])
+                readPipe(1, m_output);
+            else if (entries[i].fd == m_pipes[2])
+                readPipe(2, m_error);
+        }
+    }
+
+    // Blocks until the child exits and returns its exit code, or 128 plus
+    // the signal number if it was killed (like the shell does).
+    int wait()
+    {
+        int status = 0;
+        while (::waitpid(m_pid, &status, 0) < 0) {
+            if (errno != EINTR)
+                return -1;
+        }
+        return exitCode(status);
+    }
+
+    // Like wait(), but returns false at once if the child is still running.
+    bool tryWait(int& code)
+    {
+        int status = 0;
+        if (::waitpid(m_pid, &status, WNOHANG) <= 0)
+            return false;
+        code = exitCode(status);
+        return true;
+    }
+
+    static int exitCode(int status)
+    {
+        if (WIFEXITED(status))
+            return WEXITSTATUS(status);
+        if (WIFSIGNALED(status))
+            return 128 + WTERMSIG(status);
+        return -1;
+    }
+
+    // Hands the parent end of a pipe over to the caller.
+    int releasePipe(int index)
+    {
+        int fd = m_pipes[index];
+        m_pipes[index] = -1;
+        return fd;
+    }
+
+    const std::string& output() const { return m_output; }
+    const std::string& error() const { return m_error; }
+
+private:
+    static bool openPipe(int fds[2])
+    {
+        if (::pipe(fds) != 0)
+            return false;
+        ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+    }
+
+    bool spawn(const SpawnOptions& options, int pipes[3][2], char** argv, char** environment)
+    {
+#if !defined(HAMMERJS_HAVE_SPAWN_CHDIR)
+        if (!options.directory.empty())
+            return forkAndExec(options, pipes, argv, environment);
+#endif
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        for (int i = 0; i < 3; ++i) {
+            int childEnd = (i == 0) ? 0 : 1;
+            if (pipes[i][childEnd] >= 0)
+                posix_spawn_file_actions_adddup2(&actions, pipes[i][childEnd], i);
+        }
+#if defined(HAMMERJS_HAVE_SPAWN_CHDIR)
+        if (!options.directory.empty())
+            posix_spawn_file_actions_addchdir_np(&actions, options.directory.c_str());
+#endif
+
+        int result = posix_spawnp(&m_pid, argv[0], &actions, 0, argv, environment);
+        posix_spawn_file_actions_destroy(&actions);
+        return result == 0;
+    }
+
+#if !defined(HAMMERJS_HAVE_SPAWN_CHDIR)
+    bool forkAndExec(const SpawnOptions& options, int pipes[3][2], char** argv, char** environment)
+    {
+        m_pid = ::fork();
+        if (m_pid < 0)
+            return false;
+        if (m_pid == 0) {
+            for (int i = 0; i < 3; ++i) {
+                int childEnd = (i == 0) ? 0 : 1;
+                if (pipes[i][childEnd] >= 0)
+                    ::dup2(pipes[i][childEnd], i);
+            }
+            if (::chdir(options.directory.c_str()) != 0)
+                ::_exit(127);
+            environ = environment;
+            ::execvp(argv[0], argv);
+            ::_exit(127);
+        }
+        return true;
+    }
+#endif
+
+    void closePipe(int index)
+    {
+        if (m_pipes[index] >= 0)
+            ::close(m_pipes[index]);
+        m_pipes[index] = -1;
+    }
+
+    // A child which does not read all its input must not kill us, but the
+    // SIGPIPE disposition belongs to the whole process. So the signal is
+    // only blocked (for this thread) around the write, and one which the
+    // write raised is taken off the pending set before it is unblocked.
+    static ssize_t writeWithoutSigpipe(int fd, const char* data, size_t size)
+    {
+        sigset_t pipeSignal, previousMask, pending;
+        sigemptyset(&pipeSignal);
+        sigaddset(&pipeSignal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSignal, &previousMask);
+        sigpending(&pending);
+        bool wasPending = sigismember(&pending, SIGPIPE);
+
+        ssize_t count = ::write(fd, data, size);
+        int error = errno;
+
+        if (count < 0 && error == EPIPE && !wasPending && !sigismember(&previousMask, SIGPIPE)) {
+            sigpending(&pending);
+            if (sigismember(&pending, SIGPIPE)) {
+                int signal;
+                sigwait(&pipeSignal, &signal);
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &previousMask, 0);
+        errno = error;
+        return count;
+    }
+
+    void writeInput()
+    {
+        while (m_inputOffset < m_input.size()) {
+            ssize_t count = writeWithoutSigpipe(m_pipes[0], m_input.data() + m_inputOffset, m_input.size() - m_inputOffset);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN)
+                    return;
+                break;
+            }
+            m_inputOffset += count;
+        }
+        closePipe(0);
+    }
+
+    void readPipe(int index, std::string& text)
+    {
+        char buffer[64 * 1024];
+        ssize_t count = ::read(m_pipes[index], buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR)
+            return;
+        if (count <= 0)
+            closePipe(index);
+        else
+            text.append(buffer, count);
+    }
+
+    pid_t m_pid;
+    int m_pipes[3];
+    std::string m_input;
+    size_t m_inputOffset;
+    std::string m_output;
+    std::string m_error;
+};
+
+// Children of system.spawnStream(), which are reaped once they are done.
+static std::vector<pid_t> streamingChildren;
+
+static void reapStreamingChildren()
+{
+    for (size_t i = 0; i < streamingChildren.size(); ) {
+        int status;
+        if (::waitpid(streamingChildren[i], &status, WNOHANG) == 0) {
+            ++i;
+            continue;
+        }
+        streamingChildren.erase(streamingChildren.begin() + i);
+    }
+}
+
+// Reads the argument array of a command. A string is accepted as a shell
+// command if allowShell is set. Returns false, with an exception thrown,
+// if the command is not valid.
+static bool readCommand(Handle<Value> command, const char* function, bool allowShell, std::vector<std::string>& arguments)
+{
+    if (allowShell && command->IsString()) {
+        String::Utf8Value text(command);
+        arguments.push_back("/bin/sh");
+        arguments.push_back("-c");
+        arguments.push_back(*text);
+        return true;
+    }
+    if (!command->IsArray() || Handle<Array>::Cast(command)->Length() == 0) {
+        std::string message = std::string("Exception: ") + function + " needs a non-empty array of arguments";
+        ThrowException(String::New(message.c_str()));
+        return false;
+    }
+    Handle<Array> argv = Handle<Array>::Cast(command);
+    for (unsigned i = 0; i < argv->Length(); ++i) {
+        String::Utf8Value argument(argv->Get(i));
+        arguments.push_back(*argument);
+    }
+    return true;
+}
+
+// Reads the options shared by system.spawn() and friends.
+static void readSpawnOptions(Handle<Value> value, SpawnOptions& spawnOptions)
+{
+    if (!value->IsObject())
+        return;
+    Handle<Object> options = value->ToObject();
+
+    if (options->Has(String::New("cwd"))) {
+        String::Utf8Value directory(options->Get(String::New("cwd")));
+        spawnOptions.directory = *directory;
+    }
+    Handle<Value> environment = options->Get(String::New("env"));
+    if (environment->IsObject()) {
+        Handle<Object> variables = environment->ToObject();
+        Handle<Array> names = variables->GetPropertyNames();
+        spawnOptions.hasEnvironment = true;
+        for (unsigned i = 0; i < names->Length(); ++i) {
+            String::Utf8Value name(names->Get(i));
+            String::Utf8Value value(variables->Get(names->Get(i)));
+            spawnOptions.environment.push_back(std::string(*name) + "=" + *value);
+        }
+    }
+    if (options->Has(String::New("stdin"))) {
+        String::Utf8Value input(options->Get(String::New("stdin")));
+        spawnOptions.input.assign(*input, input.length());
+        spawnOptions.hasInput = true;
+    }
+    if (options->Has(String::New("capture"))) {
+        bool capture = options->Get(String::New("capture"))->BooleanValue();
+        spawnOptions.captureOutput = capture;
+        spawnOptions.captureError = capture;
+    }
+}
+
+// A command of system.runAll() which is running.
+struct Job {
+    ChildProcess* process;
+    unsigned index;
+    double started;
+    bool exited;
+    int status;
+};
+
+// Monotonic time in milliseconds, for the duration of a job.
+static double currentTime()
+{
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+// Stores the result of a finished job and reports it to the callback (if
+// any). Returns false if no more jobs should be started.
+static bool completeJob(const Job& job, bool capture, Handle<Array> commands, Handle<Array> results, Handle<Function> onComplete)
+{
+    HandleScope handle_scope;
+
+    Handle<Object> result = Object::New();
+    result->Set(String::NewSymbol("command"), commands->Get(job.index));
+    result->Set(String::NewSymbol("status"), Integer::New(job.status));
+    result->Set(String::NewSymbol("duration"), Number::New(currentTime() - job.started));
+    if (capture) {
+        const std::string& output = job.process->output();
+        const std::string& error = job.process->error();
+        result->Set(String::NewSymbol("stdout"), String::New(output.data(), output.size()));
+        result->Set(String::NewSymbol("stderr"), String::New(error.data(), error.size()));
+    }
+    results->Set(job.index, result);
+
+    if (onComplete.IsEmpty())
+        return true;
+    Handle<Value> argv[2] = { result, Integer::New(job.index) };
+    Handle<Value> answer = onComplete->Call(Context::GetCurrent()->Global(), 2, argv);
+    return !answer.IsEmpty() && !(answer->IsBoolean() && !answer->BooleanValue());
+}
+
+#endif
+
 extern int hammerjs_argc;
 extern char** hammerjs_argv;
 
@@ -50,10 +582,15 @@ static Handle<Value> system_execute(const Arguments& args)
         return ThrowException(String::New("Exception: function system.execute() accepts 1 argument"));
 
     String::Utf8Value cmd(args[0]);
-    ::system(*cmd);
+    flushOutput();
+    int status = ::system(*cmd);
 
+#if !defined(HAMMERJS_OS_WINDOWS)
+    if (status != -1)
+        status = ChildProcess::exitCode(status);
+#endif
 
-    return Undefined();
+    return handle_scope.Close(Integer::New(status));
 }
 
 static Handle<Value> system_exit(const Arguments& args)
@@ -69,21 +606,272 @@ static Handle<Value> system_exit(const Arguments& args)
     return Undefined();
 }
 
+static Handle<Value> system_hash(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function system.hash() accepts 1 or 2 arguments"));
+
+    String::Utf8Value algorithm(args[1]);
+    Hasher* hasher = Hasher::create((args.Length() == 2) ? *algorithm : "sha256");
+    if (!hasher)
+        return ThrowException(String::New("Exception: system.hash() does not support the algorithm"));
+
+    String::Utf8Value value(args[0]);
+    hasher->update(*value, value.length());
+    std::string digest = hasher->digest();
+    delete hasher;
+
+    return handle_scope.Close(String::New(digest.c_str(), digest.size()));
+}
+
+static Handle<Value> system_flush(const Arguments& args)
+{
+    if (args.Length() != 0)
+        return ThrowException(String::New("Exception: function system.flush() accepts no argument"));
+
+    flushOutput();
+
+    return Undefined();
+}
+
 static Handle<Value> system_print(const Arguments& args)
 {
     HandleScope handle_scope;
 
-    for (int i = 0; i < args.Length(); i++) {
-        String::Utf8Value value(args[i]);
-        std::cout << *value;
-        if (i < args.Length() - 1)
-            std::cout << ' ';
+    printArguments(standardOutput, args, true);
+
+    return Undefined();
+}
+
+static Handle<Value> system_printErr(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    // Both streams often end up in the same log, so they must keep their
+    // relative order.
+    standardOutput.flush();
+    printArguments(standardError, args, true);
+    standardError.flush();
+
+    return Undefined();
+}
+
+static Handle<Value> system_spawn(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function system.spawn() accepts 1 or 2 arguments"));
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    return ThrowException(String::New("Exception: system.spawn() is not supported on this platform"));
+#else
+    SpawnOptions options;
+    if (!readCommand(args[0], "system.spawn()", false, options.arguments))
+        return Undefined();
+    readSpawnOptions(args[1], options);
+
+    flushOutput();
+    reapStreamingChildren();
+
+    ChildProcess process;
+    if (!process.start(options))
+        return ThrowException(String::New("Exception: system.spawn() can't start the command"));
+
+    std::vector<pollfd> entries;
+    while (!process.isDrained()) {
+        entries.clear();
+        process.addPollEntries(entries);
+        if (::poll(&entries[0], entries.size(), -1) < 0 && errno != EINTR)
+            break;
+        process.handlePollEntries(entries);
+    }
+
+    Handle<Object> result = Object::New();
+    result->Set(String::NewSymbol("status"), Integer::New(process.wait()));
+    if (options.captureOutput) {
+        result->Set(String::NewSymbol("stdout"), String::New(process.output().data(), process.output().size()));
+        result->Set(String::NewSymbol("stderr"), String::New(process.error().data(), process.error().size()));
     }
-    std::cout << std::endl;
+
+    return handle_scope.Close(result);
+#endif
+}
+
+static Handle<Value> system_spawnStream(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function system.spawnStream() accepts 1 or 2 arguments"));
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    return ThrowException(String::New("Exception: system.spawnStream() is not supported on this platform"));
+#else
+    SpawnOptions options;
+    if (!readCommand(args[0], "system.spawnStream()", false, options.arguments))
+        return Undefined();
+    readSpawnOptions(args[1], options);
+    options.hasInput = false;
+    options.captureOutput = true;
+    options.captureError = false;
+
+    flushOutput();
+    reapStreamingChildren();
+
+    ChildProcess process;
+    if (!process.start(options))
+        return ThrowException(String::New("Exception: system.spawnStream() can't start the command"));
+    streamingChildren.push_back(process.pid());
+
+    // The read end of the output pipe becomes an ordinary Stream.
+    int fd = process.releasePipe(1);
+    char name[32];
+    snprintf(name, sizeof(name), "/dev/fd/%d", fd);
+
+    Handle<Context> context = Context::GetCurrent();
+    Function* streamFunction = Function::Cast(*context->Global()->Get(String::New("Stream")));
+    Handle<Value> argv[2] = { String::New(name), String::New("r") };
+    TryCatch tryCatch;
+    Handle<Object> stream = streamFunction->NewInstance(2, argv);
+    ::close(fd);
+    if (stream.IsEmpty())
+        return tryCatch.ReThrow();
+    stream->Set(String::NewSymbol("pid"), Integer::New(process.pid()));
+
+    return handle_scope.Close(stream);
+#endif
+}
+
+static Handle<Value> system_write(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    printArguments(standardOutput, args, false);
 
     return Undefined();
 }
 
+static Handle<Value> system_runAll(const Arguments& args)
+{
+    HandleScope handle_scope;
+
+    if (args.Length() != 1 && args.Length() != 2)
+        return ThrowException(String::New("Exception: function system.runAll() accepts 1 or 2 arguments"));
+
+#if defined(HAMMERJS_OS_WINDOWS)
+    return ThrowException(String::New("Exception: system.runAll() is not supported on this platform"));
+#else
+    if (!args[0]->IsArray())
+        return ThrowException(String::New("Exception: system.runAll() needs an array of commands"));
+    Handle<Array> commands = Handle<Array>::Cast(args[0]);
+
+    SpawnOptions common;
+    readSpawnOptions(args[1], common);
+    common.hasInput = false;
+
+    size_t jobs = std::max(1L, ::sysconf(_SC_NPROCESSORS_ONLN));
+    Handle<Function> onComplete;
+    if (args[1]->IsObject()) {
+        Handle<Object> options = args[1]->ToObject();
+        if (options->Has(String::New("jobs")))
+            jobs = std::max(1, options->Get(String::New("jobs"))->Int32Value());
+        Handle<Value> callback = options->Get(String::New("onComplete"));
+        if (callback->IsFunction())
+            onComplete = Handle<Function>::Cast(callback);
+    }
+
+    // Bad commands throw before anything runs.
+    unsigned count = commands->Length();
+    std::vector<std::vector<std::string> > arguments(count);
+    for (unsigned i = 0; i < count; ++i) {
+        if (!readCommand(commands->Get(i), "system.runAll()", true, arguments[i]))
+            return Undefined();
+    }
+
+    flushOutput();
+    reapStreamingChildren();
+
+    Handle<Array> results = Array::New(count);
+    std::vector<Job> running;
+    std::vector<pollfd> entries;
+    unsigned next = 0;
+    bool stopped = false;
+    TryCatch tryCatch;
+
+    while ((next < count && !stopped) || !running.empty()) {
+        while (!stopped && next < count && running.size() < jobs) {
+            SpawnOptions options = common;
+            options.arguments = arguments[next];
+            Job job;
+            job.process = new ChildProcess;
+            job.index = next++;
+            job.started = currentTime();
+            job.exited = false;
+            if (job.process->start(options)) {
+                running.push_back(job);
+                continue;
+            }
+            // Like the shell, which reports 127 for a command not found.
+            job.status = 127;
+            stopped = !completeJob(job, common.captureOutput, commands, results, onComplete);
+            delete job.process;
+        }
+        if (running.empty())
+            break;
+
+        // Move the output of the jobs still writing. A job which is done
+        // with its pipes is polled for its exit every few milliseconds.
+        entries.clear();
+        bool exiting = false;
+        for (size_t i = 0; i < running.size(); ++i) {
+            if (running[i].process->isDrained())
+                exiting = true;
+            else
+                running[i].process->addPollEntries(entries);
+        }
+        if (!entries.empty()) {
+            if (::poll(&entries[0], entries.size(), exiting ? 10 : -1) > 0) {
+                for (size_t i = 0; i < running.size(); ++i)
+                    running[i].process->handlePollEntries(entries);
+            }
+        }
+
+        // Without any pipe to watch, wait for whichever child exits first.
+        if (entries.empty()) {
+            int status;
+            pid_t pid = ::waitpid(-1, &status, 0);
+            for (size_t i = 0; i < running.size(); ++i) {
+                if (running[i].process->pid() == pid) {
+                    running[i].exited = true;
+                    running[i].status = ChildProcess::exitCode(status);
+                }
+            }
+            streamingChildren.erase(std::remove(streamingChildren.begin(), streamingChildren.end(), pid), streamingChildren.end());
+        }
+
+        for (size_t i = 0; i < running.size(); ) {
+            Job job = running[i];
+            if (!job.exited && !(job.process->isDrained() && job.process->tryWait(job.status))) {
+                ++i;
+                continue;
+            }
+            running.erase(running.begin() + i);
+            if (!tryCatch.HasCaught() && !completeJob(job, common.captureOutput, commands, results, onComplete))
+                stopped = true;
+            delete job.process;
+        }
+    }
+
+    if (tryCatch.HasCaught())
+        return tryCatch.ReThrow();
+
+    return handle_scope.Close(results);
+#endif
+}
+
 static Handle<Value> system_sleep(const Arguments& args)
 {
     HandleScope handle_scope;
@@ -103,15 +891,42 @@ static Handle<Value> system_sleep(const Arguments& args)
     return Undefined();
 }
 
+// Reports an uncaught exception like V8 does without a listener, but only
+// after the script's pending output.
+static void reportMessage(Handle<Message> message, Handle<Value>)
+{
+    flushOutput();
+
+    String::Utf8Value text(message->Get());
+    Handle<Value> resourceName = message->GetScriptResourceName();
+    if (resourceName->IsString()) {
+        String::Utf8Value name(resourceName);
+        printf("%s:%i: %s\n", *name, message->GetStartPosition(), *text);
+    } else {
+        printf("<unknown>:%i: %s\n", message->GetStartPosition(), *text);
+    }
+    fflush(stdout);
+}
+
 void setup_system(Handle<Object> object, Handle<Array> args)
 {
+    atexit(flushOutput);
+    V8::AddMessageListener(reportMessage);
+
     Handle<FunctionTemplate> systemObject = FunctionTemplate::New();
 
     systemObject->Set(String::New("args"), args);
     systemObject->Set(String::New("execute"), FunctionTemplate::New(system_execute)->GetFunction());
     systemObject->Set(String::New("exit"), FunctionTemplate::New(system_exit)->GetFunction());
+    systemObject->Set(String::New("flush"), FunctionTemplate::New(system_flush)->GetFunction());
+    systemObject->Set(String::New("hash"), FunctionTemplate::New(system_hash)->GetFunction());
     systemObject->Set(String::New("print"), FunctionTemplate::New(system_print)->GetFunction());
+    systemObject->Set(String::New("printErr"), FunctionTemplate::New(system_printErr)->GetFunction());
+    systemObject->Set(String::New("runAll"), FunctionTemplate::New(system_runAll)->GetFunction());
     systemObject->Set(String::New("sleep"), FunctionTemplate::New(system_sleep)->GetFunction());
+    systemObject->Set(String::New("spawn"), FunctionTemplate::New(system_spawn)->GetFunction());
+    systemObject->Set(String::New("spawnStream"), FunctionTemplate::New(system_spawnStream)->GetFunction());
+    systemObject->Set(String::New("write"), FunctionTemplate::New(system_write)->GetFunction());
 
     object->Set(String::New("system"), systemObject->GetFunction());
 }
@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2011 Sencha Inc.
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Parses the same sources on several threads, each with its own
+// JSGlobalData, and checks that every thread gets the trees a single thread
+// gets. Built with ThreadSanitizer when HAMMERJS_TSAN is enabled.
+//
+//   hammerjs_parser_stress threads file...
+
+#include "config.h"
+
+#include <JSGlobalData.h>
+#include <SourceCode.h>
+#include <SyntaxTree.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+static const int rounds = 3;
+
+static std::vector<std::string> sources;
+
+static unsigned long long fingerprint(const JSC::SyntaxTree::Node* node, unsigned long long hash)
+{
+    if (!node)
+        return hash * 31 + 1;
+
+    hash = hash * 31 + node->type();
+    hash = hash * 31 + node->start();
+    hash = hash * 31 + node->end();
+    for (int i = 0; i < node->childCount(); ++i)
+        hash = fingerprint(node->childAt(i), hash);
+    return hash;
+}
+
+// One fingerprint per source, parsed as Latin-1 and then as UTF-16.
+static void parseAll(JSC::JSGlobalData* globalData, std::vector<unsigned long long>& result)
+{
+    result.clear();
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const std::string& source = sources[i];
+        const LChar* characters8 = reinterpret_cast<const LChar*>(source.data());
+        std::vector<UChar> characters16(source.begin(), source.end());
+        characters16.push_back(0);
+
+        void* tree = globalData->parser->createSyntaxTree(globalData, JSC::makeSource(characters8, source.size()));
+        result.push_back(fingerprint(reinterpret_cast<JSC::SyntaxTree::Node*>(tree), 0));
+        globalData->parser->arena().reset();
+
+        tree = globalData->parser->createSyntaxTree(globalData, JSC::makeSource(&characters16[0], source.size()));
+        result.push_back(fingerprint(reinterpret_cast<JSC::SyntaxTree::Node*>(tree), 0));
+        globalData->parser->arena().reset();
+
+        // Exercises the dtoa conversions shared by all the threads.
+        JSC::UString::number(1e300 / (i + 3));
+    }
+}
+
+struct Worker {
+    pthread_t thread;
+    std::vector<unsigned long long> result;
+    bool consistent;
+};
+
+static void* work(void* data)
+{
+    Worker* worker = static_cast<Worker*>(data);
+    JSC::JSGlobalData globalData;
+    std::vector<unsigned long long> result;
+
+    worker->consistent = true;
+    for (int round = 0; round < rounds; ++round) {
+        parseAll(&globalData, result);
+        if (round > 0 && result != worker->result)
+            worker->consistent = false;
+        worker->result.swap(result);
+    }
+    return 0;
+}
+
+static bool readFile(const char* name, std::string& content)
+{
+    FILE* f = fopen(name, "rb");
+    if (!f)
+        return false;
+
+    char buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        content.append(buffer, count);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s threads file...\n", argv[0]);
+        return 1;
+    }
+
+    int threadCount = atoi(argv[1]);
+    if (threadCount < 1)
+        threadCount = 1;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string content;
+        if (!readFile(argv[i], content)) {
+            fprintf(stderr, "Can not read %s\n", argv[i]);
+            return 1;
+        }
+        sources.push_back(content);
+    }
+
+    // Numeric literals which need the big number path of strtod, and
+    // accessors, in addition to the files.
+    sources.push_back("x = 1e-320 + 123456789012345678901234567890e-300 + 0.1e400 + 2.2250738585072011e-308;");
+    sources.push_back("x = { get a() { return 1; }, set a(v) {}, b: 2 };");
+
+    std::vector<Worker> workers(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        pthread_create(&workers[i].thread, 0, work, &workers[i]);
+    for (int i = 0; i < threadCount; ++i)
+        pthread_join(workers[i].thread, 0);
+
+    // The reference parse comes last, so that the threads are the first to
+    // fill the caches they share.
+    std::vector<unsigned long long> expected;
+    {
+        JSC::JSGlobalData globalData;
+        parseAll(&globalData, expected);
+    }
+
+    int failures = 0;
+    for (int i = 0; i < threadCount; ++i) {
+        if (!workers[i].consistent || workers[i].result != expected) {
+            fprintf(stderr, "Thread %d got different syntax trees\n", i);
+            ++failures;
+        }
+    }
+
+    printf("Parsed %d sources %d times on %d threads, %d failure(s).\n",
+        static_cast<int>(sources.size()), rounds, threadCount, failures);
+    return failures ? 1 : 0;
+}
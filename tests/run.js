@@ -19,12 +19,41 @@ function readFile(fname) {
     return content;
 }
 
+function readText(fname) {
+    var f = fs.open(fname, 'r'),
+        content = f.read();
+    f.close();
+    return content;
+}
+
 function writeFile(fname, content) {
     var f = fs.open(fname, 'w');
     f.writeLine(content);
     f.close();
 }
 
+// A new empty directory for the files a test writes, or null where there
+// is no mktemp (on Windows).
+function makeScratchDirectory() {
+    if (fs.pathSeparator !== '/') {
+        return null;
+    }
+    return system.spawn(['mktemp', '-d']).stdout.replace(/\n$/, '');
+}
+
+function removeScratchDirectory(path) {
+    system.spawn(['rm', '-rf', path]);
+}
+
+function throws(f) {
+    try {
+        f();
+    } catch (e) {
+        return true;
+    }
+    return false;
+}
+
 function scanDirectory(path) {
     var entries = [],
         subdirs;
@@ -57,6 +86,263 @@ function test_fs() {
     assert(typeof fs.list === 'function');
     assert(typeof fs.open === 'function');
     assert(typeof fs.workingDirectory === 'function');
+    assert(typeof fs.stat === 'function');
+    assert(typeof fs.enableStatCache === 'function');
+    assert(typeof fs.invalidateStatCache === 'function');
+    assert(typeof fs.glob === 'function');
+    assert(typeof fs.watch === 'function');
+    assert(typeof fs.copy === 'function');
+    assert(typeof fs.concat === 'function');
+    assert(typeof fs.hash === 'function');
+    assert(typeof fs.readCSV === 'function');
+    assert(typeof fs.readJSON === 'function');
+    assert(typeof fs.readJSONLines === 'function');
+}
+
+function test_fs_stat() {
+    var info = fs.stat('tests');
+    assert(info.type === 'directory');
+    info = fs.stat('tests/run.js');
+    assert(info.type === 'file');
+    assert(info.size > 0);
+    assert(info.mtime instanceof Date);
+
+    fs.enableStatCache(true);
+    assert(fs.isFile('tests/run.js'));
+    assert(fs.stat('tests/run.js').size === info.size);
+    assert(!fs.exists('tests/does-not-exist'));
+    fs.invalidateStatCache('tests/does-not-exist');
+    fs.invalidateStatCache();
+    fs.enableStatCache(false);
+}
+
+function test_fs_glob() {
+    assert(fs.glob('tests/syntax/*.js').length === 4);
+    assert(fs.glob('**/*.syntax', { cwd: 'tests' }).length === 4);
+    assert(fs.glob('tests/syntax/[a-d]*.js').join() === 'tests/syntax/answer.js,tests/syntax/dowhile.js');
+    assert(fs.glob('tests/**/*.js', { ignore: 'tests/syntax/**' }).join() === 'tests/run.js');
+    assert(fs.glob(['tests/**/*.js', '!**/[!a]*.js']).join() === 'tests/syntax/answer.js');
+    assert(fs.glob('tests/nothing/**').length === 0);
+}
+
+function test_fs_copy() {
+    var dir = makeScratchDirectory(), one, two, all;
+    if (!dir) {
+        return;
+    }
+    one = dir + '/one.txt';
+    two = dir + '/two.txt';
+    all = dir + '/all.txt';
+    writeFile(one, 'one');
+    writeFile(two, 'two');
+
+    fs.copy(one, all);
+    assert(readText(all) === 'one\n');
+    fs.concat(all, [one, two, one]);
+    assert(readText(all) === 'one\ntwo\none\n');
+
+    // The target must not be truncated before a source is read.
+    assert(throws(function () { fs.copy(one, one); }));
+    assert(readText(one) === 'one\n');
+    assert(throws(function () { fs.copy(one, dir + '/../' + dir.split('/').pop() + '/one.txt'); }));
+    assert(readText(one) === 'one\n');
+    system.spawn(['ln', one, dir + '/link.txt']);
+    assert(throws(function () { fs.copy(dir + '/link.txt', one); }));
+    assert(readText(one) === 'one\n');
+    assert(throws(function () { fs.concat(one, [one, two]); }));
+    assert(readText(one) === 'one\n');
+    assert(throws(function () { fs.concat(all, [two, dir + '/missing.txt']); }));
+    assert(readText(all) === 'one\ntwo\none\n');
+
+    removeScratchDirectory(dir);
+}
+
+function test_fs_watch() {
+    var dir = makeScratchDirectory(), fileName, toucher, batches = [], start;
+    if (!dir || system.spawn(['uname', '-s']).stdout !== 'Linux\n') {
+        if (dir) {
+            removeScratchDirectory(dir);
+        }
+        return;
+    }
+    fileName = dir + '/watched.txt';
+    writeFile(fileName, 'one');
+
+    // The file is touched while fs.watch() blocks, which then returns once
+    // nothing has changed for the timeout.
+    toucher = system.spawnStream(['sh', '-c', 'sleep 0.2; echo two >> ' + fileName + '; echo done']);
+    start = Date.now();
+    fs.watch(dir, function (paths) {
+        batches.push(paths);
+    }, { timeout: 1000 });
+    assert(toucher.next() === 'done');
+    toucher.close();
+    assert(batches.length === 1);
+    assert(batches[0].join() === fileName);
+    assert(Date.now() - start >= 1000);
+    assert(readText(fileName) === 'one\ntwo\n');
+
+    start = Date.now();
+    fs.watch(fileName, function () {
+        batches.push([]);
+    }, { timeout: 100 });
+    assert(batches.length === 1);
+    assert(Date.now() - start < 1000);
+
+    removeScratchDirectory(dir);
+}
+
+function test_stream() {
+    var f = fs.open('tests/syntax/answer.js', 'r');
+    assert(f.read() === 'var answer = 42;\n');
+    f.close();
+    f = fs.open('tests/syntax/answer.js', 'r');
+    assert(f.readLines().join() === 'var answer = 42;');
+    f.close();
+    f = fs.open('tests/syntax/answer.js', 'r');
+    assert(f.size() === 17);
+    assert(f.readAt(4, 6) === 'answer');
+    assert(f.readAt(13, 100) === '42;\n');
+    assert(f.readAt(0, 1e15) === 'var answer = 42;\n');
+    assert(f.readAt(100, 1e15) === '');
+    assert(f.readAt(4, 0.5) === '');
+    assert(f.tell() === 0);
+    f.seek(13);
+    assert(f.next() === '42;');
+    assert(f.tell() === 17);
+    f.close();
+}
+
+function test_stream_gzip() {
+    var dir = makeScratchDirectory(), fileName, f, lines = [], i, line, count;
+    if (!dir) {
+        return;
+    }
+    // Well over the 256 KB of the compression buffers, before and after.
+    for (i = 0; i < 40000; i += 1) {
+        lines.push('line ' + i + ' ' + system.hash(String(i), 'xxh64'));
+    }
+    fileName = dir + '/lines.gz';
+    f = fs.open(fileName, 'wz');
+    for (i = 0; i < lines.length; i += 1) {
+        f.writeLine(lines[i]);
+    }
+    f.close();
+    assert(fs.stat(fileName).size < lines.join('\n').length / 2);
+    assert(system.spawn(['gzip', '-dc', fileName]).stdout === lines.join('\n') + '\n');
+
+    f = fs.open(fileName, 'rz');
+    count = 0;
+    while (true) {
+        line = f.readLine();
+        if (line.length === 0) {
+            break;
+        }
+        if (line !== lines[count] + '\n') {
+            break;
+        }
+        count += 1;
+    }
+    f.close();
+    assert(count === lines.length);
+
+    f = fs.open(fileName, 'rz');
+    assert(f.next() === lines[0]);
+    assert(f.read() === lines.slice(1).join('\n') + '\n');
+    f.close();
+
+    removeScratchDirectory(dir);
+}
+
+function test_fs_readJSON() {
+    var fileName = 'tests/syntax/answer.syntax',
+        expected = JSON.stringify(JSON.parse(readFile(fileName)));
+    assert(JSON.stringify(fs.readJSON(fileName)) === expected);
+    assert(fs.readJSON(fileName).body[0].type === 'VariableDeclaration');
+}
+
+function test_fs_readJSONLines() {
+    var values = [], indices = [], count, message = '', dir;
+    count = fs.readJSONLines('tests/json/events.ndjson', function (value, index) {
+        values.push(value);
+        indices.push(index);
+    });
+    assert(count === 4);
+    assert(indices.join() === '0,1,2,3');
+    assert(values[0].type === 'start');
+    assert(JSON.stringify(values[1]) === '{"type":"error","message":"disk full","tags":["io",2]}');
+    assert(values[2].join() === '1,2,3');
+    assert(values[3] === 'last');
+
+    count = fs.readJSONLines('tests/json/events.ndjson', function (value, index) {
+        return index < 1;
+    });
+    assert(count === 2);
+
+    // The values before a malformed line are still passed on, then the
+    // error names the line (blank lines included in the count).
+    values = [];
+    try {
+        fs.readJSONLines('tests/json/malformed.ndjson', function (value) {
+            values.push(value.n);
+        });
+    } catch (e) {
+        message = String(e);
+    }
+    assert(values.join() === '1,2');
+    assert(message.match('at line 4$'));
+
+    dir = makeScratchDirectory();
+    if (!dir) {
+        return;
+    }
+    writeFile(dir + '/numbers.ndjson', '[0, -0.5, 1.25e2, 2E-1, 3e+0, 123456789012345678]');
+    fs.readJSONLines(dir + '/numbers.ndjson', function (value) {
+        values = value;
+    });
+    assert(values.join() === [0, -0.5, 125, 0.2, 3, 123456789012345678].join());
+    ['01', '-', '1.', '[1e]', '[1e+]', '1.e5', '[1E-]', '.5'].forEach(function (text) {
+        writeFile(dir + '/number.ndjson', text);
+        message = '';
+        try {
+            fs.readJSONLines(dir + '/number.ndjson', function () {});
+        } catch (e) {
+            message = String(e);
+        }
+        assert(message.match(text === '.5' ? 'unexpected character' : 'invalid number'));
+    });
+    removeScratchDirectory(dir);
+}
+
+function test_fs_readCSV() {
+    var rows;
+    rows = fs.readCSV('tests/csv/rfc4180.csv');
+    assert(rows.length === 3);
+    assert(rows[0].name === 'Smith, John');
+    assert(rows[0].quote === 'He said "hi"');
+    assert(rows[0].count === 3);
+    assert(rows[1].quote === 'line one\r\nline two');
+    assert(rows[1].count === '007');
+    assert(JSON.stringify(rows[2]) === '{"name":"last","quote":"x","count":"42"}');
+    rows = fs.readCSV('tests/csv/rfc4180.csv', { columns: ['quote'] });
+    assert(JSON.stringify(rows) === '[{"quote":"He said \\"hi\\""},{"quote":"line one\\r\\nline two"},{"quote":"x"}]');
+    rows = fs.readCSV('tests/csv/rfc4180.csv', { header: false, columns: [2, 0] });
+    assert(JSON.stringify(rows) === '[["count","name"],[3,"Smith, John"],["007","plain"],["42","last"]]');
+    rows = fs.readCSV('tests/csv/rfc4180.csv', { columns: [] });
+    assert(JSON.stringify(rows) === '[{},{},{}]');
+    rows = fs.readCSV('tests/csv/rfc4180.csv', { header: false, columns: [] });
+    assert(JSON.stringify(rows) === '[[],[],[],[]]');
+    assert(throws(function () { fs.readCSV('tests/csv/rfc4180.csv', { columns: [-1] }); }));
+    assert(throws(function () { fs.readCSV('tests/csv/rfc4180.csv', { columns: [0.5] }); }));
+    assert(throws(function () { fs.readCSV('tests/csv/rfc4180.csv', { columns: [1e12] }); }));
+    assert(throws(function () { fs.readCSV('tests/csv/rfc4180.csv', { header: false, columns: [0, 0] }); }));
+    assert(throws(function () { fs.readCSV('tests/csv/rfc4180.csv', { columns: ['name', 0] }); }));
+    rows = fs.readCSV('tests/csv/rfc4180.csv', { header: false, columns: [5] });
+    assert(JSON.stringify(rows) === '[[null],[null],[null],[null]]');
+    rows = fs.readCSV('tests/csv/quoted_last.csv');
+    assert(JSON.stringify(rows) === '[{"a":1,"b":"xy"}]');
+    rows = fs.readCSV('tests/csv/unterminated.csv', { header: false });
+    assert(JSON.stringify(rows) === '[["a","b"],[1,"unterminated"]]');
 }
 
 function test_system() {
@@ -64,11 +350,205 @@ function test_system() {
     assert(typeof system.execute === 'function');
     assert(typeof system.exit === 'function');
     assert(typeof system.print === 'function');
+    assert(typeof system.hash === 'function');
+    assert(typeof system.flush === 'function');
+    assert(typeof system.printErr === 'function');
+    assert(typeof system.write === 'function');
+    assert(typeof system.spawn === 'function');
+    assert(typeof system.spawnStream === 'function');
+    assert(typeof system.runAll === 'function');
+}
+
+// The script's output is buffered, but must keep its order with the standard
+// error and with the report of an uncaught exception when both streams go
+// to the same pipe.
+function test_output_order() {
+    var dir = makeScratchDirectory(), shell, script, result;
+    if (!dir) {
+        return;
+    }
+    shell = system.spawn(['sh', '-c', 'readlink /proc/$PPID/exe']).stdout.replace(/\n$/, '');
+    if (shell.length === 0) {
+        removeScratchDirectory(dir);
+        return;
+    }
+    script = dir + '/order.js';
+    writeFile(script, "system.print('one'); system.printErr('two'); system.write('three');\n" +
+        "system.printErr('four'); system.print(''); throw new Error('five');");
+    result = system.spawn(['sh', '-c', '"$0" "$1" 2>&1', shell, script]);
+    assert(result.stdout.match(/^one\ntwo\nthreefour\n\n[^\n]*: Uncaught Error: five\n$/));
+    removeScratchDirectory(dir);
+}
+
+function test_hash() {
+    var digests;
+    assert(system.hash('abc') === 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad');
+    assert(system.hash('', 'sha256') === 'e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855');
+    assert(system.hash('', 'xxh64') === 'ef46db3751d8e999');
+    assert(system.hash('Nobody inspects the spammish repetition', 'xxh64') === 'fbcea83c8a378bf1');
+    assert(fs.hash('tests/syntax/answer.js') === system.hash('var answer = 42;\n'));
+    digests = fs.hash(['tests/syntax/answer.js', 'tests/nothing', 'tests/run.js'], 'xxh64');
+    assert(digests[0] === fs.hash('tests/syntax/answer.js', 'xxh64'));
+    assert(digests[1] === null);
+    assert(digests[2] === fs.hash('tests/run.js', 'xxh64'));
+}
+
+function test_spawn() {
+    var result;
+    if (fs.pathSeparator !== '/') {
+        return;
+    }
+    result = system.spawn(['sh', '-c', 'cat; echo oops >&2; exit 3'], { stdin: 'hello' });
+    assert(result.status === 3);
+    assert(result.stdout === 'hello');
+    assert(result.stderr === 'oops\n');
+    assert(system.spawn(['pwd'], { cwd: 'tests/syntax' }).stdout.match('tests/syntax\n$'));
+
+    // A child which does not read its input fails the write with EPIPE,
+    // without leaving SIGPIPE ignored: a later child can still die of it.
+    result = system.spawn(['true'], { stdin: new Array(1 << 20).join('x') });
+    assert(result.status === 0);
+    assert(system.execute("sh -c 'kill -PIPE $$; exit 3'") === 141);
+
+    var stream = system.spawnStream(['sh', '-c', 'echo one; sleep 0.1; echo two; pwd'], { cwd: 'tests/syntax' });
+    assert(stream.pid > 0);
+    assert(stream.next() === 'one');
+    assert(stream.next() === 'two');
+    assert(stream.next().match('tests/syntax$'));
+    assert(throws(function () { stream.next(); }));
+    stream.close();
+    stream = system.spawnStream(['yes']);
+    assert(stream.next() === 'y');
+    stream.close();
+
+    result = system.runAll(['echo one', ['sh', '-c', 'exit 2'], 'echo three'], { jobs: 2 });
+    assert(result.length === 3);
+    assert(result[0].stdout === 'one\n');
+    assert(result[1].status === 2);
+    assert(result[2].stdout === 'three\n');
+    assert(result[2].duration >= 0);
 }
 
 function test_Reflect() {
     assert(typeof Reflect === 'function');
     assert(typeof Reflect.parse === 'function');
+    assert(typeof Reflect.stats === 'function');
+    assert(typeof Reflect.parseFiles === 'function');
+    var tree = Reflect.parse('var answer = 42;\nanswer++;', { range: true, loc: true });
+    assert(tree.body[0].range[0] === 0);
+    assert(tree.body[0].range[1] === 16);
+    assert(tree.body[1].range[0] === 17);
+    assert(tree.body[1].loc.start.line === 2);
+    assert(tree.body[1].loc.start.column === 0);
+    assert(tree.body[1].loc.end.column === 9);
+    assert(Reflect.parse('answer;').body[0].range === undefined);
+    assert(JSON.stringify(Reflect.parse('f(1, "a")')) === JSON.stringify(Reflect.parse('f(1, "a")')));
+    tree = Reflect.parse('var s = "h\u00e9llo \u2603"; s;', { range: true });
+    assert(tree.body[0].declarations[0].right.value === 'h\u00e9llo \u2603');
+    assert(tree.body[1].range[0] === 19);
+    assert(Reflect.parse('switch (x) { case 1: a; default: b; case 2: c; }').body[0].cases.length === 3);
+    tree = Reflect.parse('/* a long ** comment, well past one block */  someRatherLongIdentifier_$42 = ' +
+        '"a string that is long enough \\"to need\\" several blocks"; // trailing comment\n\t\t   x;', { range: true });
+    assert(tree.body[0].expression.left.name === 'someRatherLongIdentifier_$42');
+    assert(tree.body[0].expression.right.value === 'a string that is long enough "to need" several blocks');
+    assert(tree.body[1].range[0] === 161);
+    tree = Reflect.parse('var \\u0061b = "caf\\xe9"; ab;');
+    assert(JSON.stringify(tree) === JSON.stringify(Reflect.parse('var ab = "caf\u00e9"; ab; // \u2603')));
+    assert(tree.body[0].declarations[0].right.value === 'caf\u00e9');
+    tree = Reflect.parse('[0, 255, 0.1, 3.25e2, .5, 1e23, 2.2250738585072014e-308, 0.30000000000000004, 1e400]');
+    assert(tree.body[0].expression.elements.map(function (e) { return e.value; }).join() ===
+        [0, 255, 0.1, 325, 0.5, 1e23, 2.2250738585072014e-308, 0.30000000000000004, Infinity].join());
+    tree = Reflect.parse('x = { a: 1, get b() { return 2; }, set b(v) {} };');
+    assert(tree.body[0].expression.right.properties.map(function (p) { return p.kind; }).join() === ',get,set');
+    assert(tree.body[0].expression.right.properties[1].value.type === 'FunctionExpression');
+    assert(tree.body[0].expression.right.properties[2].value.params[0].name === 'v');
+    var duplicate = false;
+    try {
+        Reflect.parse('x = { get a() {}, get a() {} };');
+    } catch (e) {
+        duplicate = true;
+    }
+    assert(duplicate);
+    var files = fs.glob('tests/syntax/*.js').concat(['tests/nothing', 'tests/run.js']),
+        trees = Reflect.parseFiles(files, { threads: 3, loc: true });
+    assert(trees.length === 6);
+    assert(JSON.stringify(trees[0]) === JSON.stringify(Reflect.parse(readFile(files[0]), { loc: true })));
+    assert(trees[4] instanceof Error);
+    assert(JSON.stringify(trees[5]) === JSON.stringify(Reflect.parse(readFile('tests/run.js'), { loc: true })));
+    assert(JSON.stringify(Reflect.parseFiles(files, { threads: 1, loc: true })) === JSON.stringify(trees));
+    var dir = makeScratchDirectory();
+    if (dir) {
+        fs.open(dir + '/empty.js', 'w').close();
+        trees = Reflect.parseFiles([dir + '/empty.js', dir + '/empty.js'], { loc: true, range: true });
+        assert(JSON.stringify(trees) === '[{"type":"Program","body":[]},{"type":"Program","body":[]}]');
+        removeScratchDirectory(dir);
+    }
+    // Many threads parsing the syntax tests at once must agree with one.
+    files = [];
+    while (files.length < 200) {
+        files = files.concat(fs.glob('tests/syntax/*.js'));
+    }
+    trees = Reflect.parseFiles(files, { threads: 8 }).map(function (t) { return JSON.stringify(t); });
+    assert(trees.every(function (t, i) { return t === JSON.stringify(Reflect.parse(readFile(files[i]))); }));
+    var stats = Reflect.stats();
+    assert(stats.bytesAllocated > 0);
+    assert(stats.peakBytes > 0 && stats.peakBytes <= stats.bytesAllocated);
+    assert(stats.pools > 0 && stats.poolBytes >= stats.peakBytes);
+}
+
+// Every reserved word, and the words that differ from one by a prefix, a
+// suffix or a single character, must lex as a keyword exactly when they are
+// in the list (see modules/reflect/parser/create_keyword_table.js).
+function test_keywords() {
+    var keywords = ['break', 'case', 'catch', 'const', 'continue', 'debugger', 'default',
+            'delete', 'do', 'else', 'false', 'finally', 'for', 'function', 'if', 'in',
+            'instanceof', 'new', 'null', 'return', 'switch', 'this', 'throw', 'true', 'try',
+            'typeof', 'var', 'void', 'while', 'with', 'class', 'enum', 'export', 'extends',
+            'import', 'super'],
+        literals = { 'true': 'Literal', 'false': 'Literal', 'null': 'Literal', 'this': 'ThisExpression' },
+        alphabet = 'abcdefghijklmnopqrstuvwxyz_$A0',
+        words = {},
+        failures = [];
+
+    keywords.concat(['let', 'yield', 'static', 'get', 'set', 'arguments', 'undefined']).forEach(function (word) {
+        var i, j;
+        words[word] = true;
+        for (i = 1; i < word.length; i += 1) {
+            words[word.slice(0, i)] = true;
+            words[word.slice(i)] = true;
+        }
+        for (j = 0; j < alphabet.length; j += 1) {
+            words[word + alphabet[j]] = true;
+            words[alphabet[j] + word] = true;
+            for (i = 0; i < word.length; i += 1) {
+                words[word.slice(0, i) + alphabet[j] + word.slice(i + 1)] = true;
+            }
+        }
+    });
+
+    Object.keys(words).forEach(function (word) {
+        var expression = null;
+        if (/^[0-9]/.test(word)) {
+            return;
+        }
+        try {
+            expression = Reflect.parse('x = ' + word + ';').body[0].expression.right;
+        } catch (e) {
+        }
+        if (keywords.indexOf(word) < 0) {
+            if (!expression || expression.type !== 'Identifier' || expression.name !== word) {
+                failures.push(word);
+            }
+        } else if (literals.hasOwnProperty(word)) {
+            if (!expression || expression.type !== literals[word]) {
+                failures.push(word);
+            }
+        } else if (expression) {
+            failures.push(word);
+        }
+    });
+    assert(Object.keys(words).length > 5000);
+    assert(failures.join() === '');
 }
 
 function test_parser() {
@@ -104,8 +584,21 @@ function test_parser() {
 
 try {
     test_fs();
+    test_fs_stat();
+    test_fs_glob();
+    test_fs_copy();
+    test_fs_watch();
+    test_stream();
+    test_stream_gzip();
+    test_fs_readCSV();
+    test_fs_readJSON();
+    test_fs_readJSONLines();
     test_system();
+    test_output_order();
+    test_hash();
+    test_spawn();
     test_Reflect();
+    test_keywords();
 } catch (e) {
     system.print(e.message);
     system.print(e.stack);